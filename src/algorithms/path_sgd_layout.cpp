@@ -156,10 +156,10 @@ namespace odgi {
                             // everyone tries to seed with their own random data
                             const std::uint64_t seed = 9399220 + tid;
                             XoshiroCpp::Xoshiro256Plus gen(seed); // a nice, fast PRNG
-                            // some references to literal bitvectors in the path index hmmm
-                            const sdsl::bit_vector &np_bv = path_index.get_np_bv();
-                            const sdsl::int_vector<> &nr_iv = path_index.get_nr_iv();
-                            const sdsl::int_vector<> &npi_iv = path_index.get_npi_iv();
+                            // views of the node->path vectors, read in place from a mapped index
+                            const xp::mapped_int_vector np_bv = path_index.get_np_bv_view();
+                            const xp::mapped_int_vector nr_iv = path_index.get_nr_iv_view();
+                            const xp::mapped_int_vector npi_iv = path_index.get_npi_iv_view();
                             // we'll sample from all path steps
                             std::uniform_int_distribution<uint64_t> dis_step = std::uniform_int_distribution<uint64_t>(0, np_bv.size() - 1);
                             std::uniform_int_distribution<uint64_t> flip(0, 1);
@@ -541,15 +541,15 @@ namespace odgi {
             std::mt19937 gen(seed);
             std::uniform_int_distribution<uint64_t> dis(1, num_nodes);
             if (sample_from_path_steps) {
-                dis = std::uniform_int_distribution<uint64_t>(0, path_index.get_np_bv().size() - 1);
+                dis = std::uniform_int_distribution<uint64_t>(0, path_index.get_np_bv_view().size() - 1);
             }
             if (sample_from_paths) {
                 dis = std::uniform_int_distribution<uint64_t>(0, total_path_len_in_nucleotides - 1);
             }
             std::uniform_int_distribution<uint64_t> flip(0, 1);
-            const sdsl::bit_vector &np_bv = path_index.get_np_bv();
-            const sdsl::int_vector<> &nr_iv = path_index.get_nr_iv();
-            const sdsl::int_vector<> &npi_iv = path_index.get_npi_iv();
+            const xp::mapped_int_vector np_bv = path_index.get_np_bv_view();
+            const xp::mapped_int_vector nr_iv = path_index.get_nr_iv_view();
+            const xp::mapped_int_vector npi_iv = path_index.get_npi_iv_view();
             auto &np_bv_select = path_index.get_np_bv_select();
             uint64_t hit_num_paths = 0;
             step_handle_t s_h;
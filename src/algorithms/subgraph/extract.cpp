@@ -226,6 +226,74 @@ namespace odgi {
             }
         }
 
+        void extract_indexed_path_range(const graph_t &source, const xp::XP &path_index, const path_handle_t &path,
+                                        uint64_t start, uint64_t end, graph_t &subgraph) {
+            step_handle_t step = path_index.get_step_at_position(path, start);
+            const uint64_t last_rank = as_integers(path_index.get_step_at_position(path, end))[1];
+            for ( ; as_integers(step)[1] <= last_rank; ++as_integers(step)[1]) {
+                const handle_t h = path_index.get_handle_of_step(step);
+                const nid_t id = source.get_id(h);
+                if (!subgraph.has_node(id)) {
+                    subgraph.create_handle(source.get_sequence(source.get_is_reverse(h) ? source.flip(h) : h), id);
+                }
+            }
+        }
+
+        void add_indexed_subpaths_to_subgraph(const graph_t &source, const xp::XP &path_index, graph_t &subgraph) {
+            std::vector<std::pair<uint64_t, uint64_t>> steps; // path rank, step rank
+            subgraph.for_each_handle([&](const handle_t &h) {
+                path_index.for_each_step_on_handle(source.get_handle(subgraph.get_id(h)), [&](const step_handle_t &step) {
+                    steps.push_back(std::make_pair(as_integers(step)[0], as_integers(step)[1]));
+                    return true;
+                });
+            });
+            std::sort(steps.begin(), steps.end());
+            for (uint64_t i = 0; i < steps.size(); ) {
+                // a subpath is a run of consecutive steps on the same path
+                uint64_t j = i + 1;
+                while (j < steps.size() && steps[j].first == steps[i].first
+                       && steps[j].second == steps[j - 1].second + 1) {
+                    ++j;
+                }
+                step_handle_t step;
+                as_integers(step)[0] = steps[i].first;
+                as_integers(step)[1] = steps[i].second;
+                const path_handle_t path = path_index.get_path_handle_of_step(step);
+                const std::string path_name = path_index.get_path_name(path);
+                const uint64_t subpath_start = path_index.get_position_of_step(step);
+                as_integers(step)[1] = steps[j - 1].second;
+                const uint64_t subpath_end = path_index.get_position_of_step(step)
+                    + source.get_length(path_index.get_handle_of_step(step));
+                const path_handle_t subpath = subgraph.create_path_handle(
+                        make_path_name(path_name, subpath_start, subpath_end),
+                        path_index.get_path(path_name).is_circular);
+                for (uint64_t k = i; k < j; ++k) {
+                    as_integers(step)[1] = steps[k].second;
+                    const handle_t h = path_index.get_handle_of_step(step);
+                    subgraph.append_step(subpath, subgraph.get_handle(source.get_id(h), source.get_is_reverse(h)));
+                }
+                i = j;
+            }
+        }
+
+        double indexed_path_range_depth(const graph_t &source, const xp::XP &path_index, const path_handle_t &path,
+                                        uint64_t start, uint64_t end,
+                                        std::vector<std::pair<nid_t, uint64_t>> &step_depths) {
+            step_handle_t step = path_index.get_step_at_position(path, start);
+            const uint64_t last_rank = as_integers(path_index.get_step_at_position(path, end))[1];
+            double depth_sum = 0;
+            for ( ; as_integers(step)[1] <= last_rank; ++as_integers(step)[1]) {
+                const handle_t h = path_index.get_handle_of_step(step);
+                const uint64_t step_start = path_index.get_position_of_step(step);
+                const uint64_t step_end = step_start + source.get_length(h);
+                const uint64_t depth = source.get_step_count(h);
+                // the first and last steps may cover only part of their node
+                depth_sum += (double)depth * (double)(std::min(step_end, end + 1) - std::max(step_start, start));
+                step_depths.push_back(std::make_pair(source.get_id(h), depth));
+            }
+            return depth_sum / (double)(end - start + 1);
+        }
+
         /// We can accumulate a subgraph without accumulating all the edges between its nodes
         /// this helper ensures that we get the full set
         void add_connecting_edges_to_subgraph(const graph_t &source, graph_t &subgraph,
@@ -1,6 +1,7 @@
 #ifndef ODGI_EXTRACT_H
 #define ODGI_EXTRACT_H
 
+#include <algorithm>
 #include <regex>
 #include <unordered_map>
 #include <stack>
@@ -12,6 +13,7 @@
 #include "utils.hpp"
 #include "position.hpp"
 #include "src/algorithms/subgraph/region.hpp"
+#include "src/algorithms/xp.hpp"
 
 namespace odgi {
     namespace algorithms {
@@ -30,6 +32,23 @@ namespace odgi {
         void for_handle_in_path_range(const graph_t &source, path_handle_t path_handle, int64_t start, int64_t end,
                                       const std::function<void(const handle_t&)>& lambda);
 
+        /// Copy the nodes that the steps of the 0-based, inclusive path range [start, end] visit, as
+        /// extract_path_range does, but found through the path index rather than by walking the path
+        void extract_indexed_path_range(const graph_t &source, const xp::XP &path_index, const path_handle_t &path,
+                                        uint64_t start, uint64_t end, graph_t &subgraph);
+
+        /// Add the subpaths of every indexed path through the subgraph, named as add_subpaths_to_subgraph
+        /// names them. They are found through the steps on the nodes of the subgraph, so this takes time
+        /// in the size of the subgraph rather than of the paths. The index must have its node step index.
+        void add_indexed_subpaths_to_subgraph(const graph_t &source, const xp::XP &path_index, graph_t &subgraph);
+
+        /// The mean depth of the 0-based, inclusive path range [start, end], weighing the depth of each
+        /// step by the bases of the range it covers, as odgi depth -r does. The node id and depth of each
+        /// step in the range are appended to step_depths.
+        double indexed_path_range_depth(const graph_t &source, const xp::XP &path_index, const path_handle_t &path,
+                                        uint64_t start, uint64_t end,
+                                        std::vector<std::pair<nid_t, uint64_t>> &step_depths);
+
         void add_connecting_edges_to_subgraph(const graph_t &source, graph_t &subgraph,
                                               const std::string &progress_message = "");
 
@@ -1,4 +1,11 @@
 #include "xp.hpp"
+#include "membuf.hpp"
+#include <unistd.h>
+#include <algorithm>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include "ips4o.hpp"
 
 // #define debug_load
 // #define debug_np
@@ -10,49 +17,75 @@ namespace xp {
     // Here is XP
     ////////////////////////////////////////////////////////////////////////////
 
+    namespace {
+        /// A step on a node, as sorted in memory while building the node->path vectors
+        struct node_path_record_t {
+            uint64_t step_rank;
+            uint64_t path_id;
+            uint64_t handle_rank;
+            bool operator<(const node_path_record_t& other) const {
+                return std::tie(step_rank, path_id, handle_rank)
+                    < std::tie(other.step_rank, other.path_id, other.handle_rank);
+            }
+        };
+    }
+
     XP::~XP() {
-        // Clean up any created XPPaths
-        while (!paths.empty()) {
-            delete paths.back();
-            paths.pop_back();
-        }
-        path_count = 0;
+        clean();
     }
 
     /// build the graph from a graph handle
-    void XP::from_handle_graph(const PathHandleGraph &graph, const uint64_t& nthreads) {
+    void XP::from_handle_graph(const PathHandleGraph &graph, const uint64_t& nthreads,
+                               const node_path_sort_t node_path_sort) {
         std::string basename;
-        from_handle_graph(graph, basename, nthreads);
+        from_handle_graph(graph, basename, nthreads, node_path_sort);
     }
 
-    void XP::from_handle_graph(const PathHandleGraph &graph, std::string basename, const uint64_t& nthreads) {
+    void XP::from_handle_graph(const PathHandleGraph &graph, std::string basename, const uint64_t& nthreads,
+                               const node_path_sort_t node_path_sort) {
         // create temporary file for path names
         if (basename.empty()) {
             basename = temp_file::create();
         }
-        from_handle_graph_impl(graph, basename, nthreads);
+        from_handle_graph_impl(graph, basename, nthreads, node_path_sort);
         temp_file::cleanup(); // clean up our temporary files
     }
 
-    void XP::from_handle_graph_impl(const PathHandleGraph &graph, const std::string& basename, const uint64_t& nthreads) {
+    void XP::from_handle_graph_impl(const PathHandleGraph &graph, const std::string& basename, const uint64_t& nthreads,
+                                    const node_path_sort_t node_path_sort) {
         std::string path_names;
-        // the graph must be compacted for this to work
-        sdsl::int_vector<> position_map;
-        sdsl::util::assign(position_map, sdsl::int_vector<>(graph.get_node_count() + 1));
-        uint64_t len = 0;
-        nid_t last_node_id = graph.min_node_id();
+        // node ids may have gaps, so we record which handle numbers are in use and index nodes by their rank among them
+        uint64_t node_count = graph.get_node_count();
+        uint64_t max_number = 0;
         graph.for_each_handle([&](const handle_t &h) {
-            nid_t node_id = graph.get_id(h);
-            if (node_id - last_node_id > 1) {
-                std::cerr << "error [xp]: Graph to index is not optimized. Please run 'odgi sort' using -O, --optimize" << std::endl;
-                exit(1);
-            }
-            position_map[number_bool_packing::unpack_number(h)] = len;
-            uint64_t hl = graph.get_length(h);
-            len += hl;
-            last_node_id = node_id;
+            max_number = std::max(max_number, (uint64_t)number_bool_packing::unpack_number(h));
         });
-        position_map[position_map.size() - 1] = len;
+        if (node_count > 0 && max_number + 1 != node_count) {
+            sdsl::util::assign(node_present, sdsl::bit_vector(max_number + 1));
+            graph.for_each_handle([&](const handle_t &h) {
+                node_present[number_bool_packing::unpack_number(h)] = 1;
+            });
+            sdsl::util::assign(node_present_rank, sdsl::rank_support_v<1>(&node_present));
+        } else {
+            sdsl::util::clear(node_present);
+            sdsl::util::clear(node_present_rank);
+        }
+        // node lengths and step counts by node rank; the step counts may include
+        // destroyed steps, so they only bound how many records a node gets
+        sdsl::int_vector<> position_map;
+        sdsl::util::assign(position_map, sdsl::int_vector<>(node_count + 1));
+        std::vector<uint64_t> np_slots(node_count + 1, 0);
+        graph.for_each_handle([&](const handle_t &h) {
+            uint64_t rank = node_rank(number_bool_packing::unpack_number(h));
+            position_map[rank + 1] = graph.get_length(h);
+            np_slots[rank + 1] = graph.get_step_count(h);
+        }, true);
+        // each node starts where the ones before it end
+        for (uint64_t i = 0; i < node_count; ++i) {
+            position_map[i + 1] += position_map[i];
+            np_slots[i + 1] += np_slots[i];
+        }
+        uint64_t len = position_map[node_count];
 #ifdef debug_from_handle_graph
         std::cerr << "[XP CONSTRUCTION]: The current graph to index has nucleotide length: " << len << std::endl;
         std::cerr << "[XP CONSTRUCTION]: position_map: ";
@@ -63,31 +96,73 @@ namespace xp {
 #endif
         // record the number of nodes + the number of paths within each node
         uint64_t np_size = 0;
-        std::string node_path_idx = basename + ".node_path.mm";
-        // we fill the multiset with a tuple[handle id, step_rank, path_id, rank_of_handle_in_path]
-        mmmulti::map<uint64_t , std::tuple<uint64_t, uint64_t, uint64_t, uint64_t>>
-            node_path_ms(node_path_idx, std::make_tuple(0, 0, 0, 0));
-        node_path_ms.open_writer();
+        // fix the path order up front so that each path can be indexed on its own thread
+        std::vector<path_handle_t> path_handles;
+        uint64_t step_count = 0;
         graph.for_each_path_handle([&](const path_handle_t &path) {
+            path_handles.push_back(path);
+            step_count += graph.get_step_count(path);
+        });
+        bool in_memory = node_path_sort == node_path_sort_t::in_memory;
+        if (node_path_sort == node_path_sort_t::automatic) {
+            // the in-memory sort holds one record per step on top of the vectors both ways build
+            uint64_t needed = step_count * sizeof(node_path_record_t) + (node_count + 1) * 2 * sizeof(uint64_t);
+            uint64_t available = (uint64_t)sysconf(_SC_AVPHYS_PAGES) * (uint64_t)sysconf(_SC_PAGE_SIZE);
+            in_memory = needed <= available / 2;
+        }
+        // the in-memory sort places each record in its node's range of a flat array
+        std::vector<node_path_record_t> node_path_records;
+        // the records each node actually gets
+        std::unique_ptr<std::atomic<uint64_t>[]> np_filled(new std::atomic<uint64_t>[node_count]());
+        // the on-disk sort fills a multiset with a tuple[node rank + 1, step_rank, path_id, rank_of_handle_in_path]
+        std::unique_ptr<mmmulti::map<uint64_t , std::tuple<uint64_t, uint64_t, uint64_t, uint64_t>>> node_path_ms;
+        if (in_memory) {
+            node_path_records.resize(np_slots[node_count]);
+        } else {
+            std::string node_path_idx = basename + ".node_path.mm";
+            node_path_ms.reset(new mmmulti::map<uint64_t , std::tuple<uint64_t, uint64_t, uint64_t, uint64_t>>(
+                node_path_idx, std::make_tuple(0, 0, 0, 0)));
+            node_path_ms->open_writer();
+        }
+        paths.resize(path_handles.size());
+        std::mutex node_path_mutex;
+#pragma omp parallel for schedule(dynamic,1) num_threads(nthreads) reduction(+:np_size)
+        for (uint64_t i = 0; i < path_handles.size(); ++i) {
+            const path_handle_t& path = path_handles[i];
             std::vector<handle_t> p;
+            std::vector<std::tuple<uint64_t, uint64_t, uint64_t, uint64_t>> node_paths;
             uint64_t handle_rank_in_path = 0;
             graph.for_each_step_in_path(path, [&](const step_handle_t &occ) {
                 handle_t h = graph.get_handle_of_step(occ);
                 uint64_t step_rank = as_integers(occ)[1];
                 p.push_back(h);
-                uint64_t hl = graph.get_length(h);
                 ++handle_rank_in_path; // handle ranks in path are 1-based
-                size_t node_id = graph.get_id(h);
-                node_path_ms.append(node_id, std::make_tuple(node_id, step_rank, as_integer(path), handle_rank_in_path));
-                np_size++;
+                uint64_t rank = node_rank(number_bool_packing::unpack_number(h));
+                uint64_t filled = np_filled[rank].fetch_add(1);
+                if (in_memory) {
+                    uint64_t slot = np_slots[rank] + filled;
+                    node_path_records[slot] = node_path_record_t{ step_rank, (uint64_t)as_integer(path), handle_rank_in_path };
+                    ++np_size;
+                } else {
+                    // keyed by node rank + 1, which is the node id in a compacted graph
+                    node_paths.push_back(std::make_tuple(rank + 1, step_rank, as_integer(path), handle_rank_in_path));
+                }
             });
+            if (!in_memory) {
+                np_size += node_paths.size();
+                // append the whole path at once; index() sorts the records, so the order threads get here in does not matter
+                std::lock_guard<std::mutex> guard(node_path_mutex);
+                for (auto& v : node_paths) {
+                    node_path_ms->append(std::get<0>(v), v);
+                }
+            }
             std::string path_name = graph.get_path_name(path);
             // std::cout << "[XP CONSTRUCTION]: Indexing path: " << path_name << std::endl;
-            XPPath *path_index = new XPPath(path_name, p, false, graph);
-            // Add path_index to paths.
-            paths.push_back(path_index);
-            path_names += start_marker + path_name + end_marker;
-        });
+            paths[i] = new XPPath(path_name, p, false, graph);
+        }
+        for (auto& path : path_handles) {
+            path_names += start_marker + graph.get_path_name(path) + end_marker;
+        }
         // assign the position map iv
         sdsl::util::assign(pos_map_iv, sdsl::enc_vector<>(position_map));
         // set the path counts
@@ -95,40 +170,45 @@ namespace xp {
 #ifdef debug_from_handle_graph
         std::cout << "[XP CONSTRUCTION]: path_count: " << path_count << std::endl;
 #endif
-        // handle path names
-        sdsl::util::assign(pn_iv, sdsl::int_vector<>(path_names.size()));
-        sdsl::util::assign(pn_bv, sdsl::bit_vector(path_names.size()));
-        // now record path name starts
-        for (size_t i = 0; i < path_names.size(); ++i) {
-            pn_iv[i] = path_names[i];
-            if (path_names[i] == start_marker) {
-                pn_bv[i] = 1; // register name start
-            }
-        }
-        sdsl::util::assign(pn_bv_rank, sdsl::rank_support_v<1>(&pn_bv));
-        sdsl::util::assign(pn_bv_select, sdsl::bit_vector::select_1_type(&pn_bv));
-
-        // write path names to temp file
-        std::string path_name_file = basename + ".pathnames.iv";
-        sdsl::store_to_file((const char *) path_names.c_str(), path_name_file);
-        // read file and construct compressed suffix array
-        sdsl::construct(pn_csa, path_name_file, 1);
+        set_path_names(path_names, basename + ".pathnames.iv");
         // we need to take care of the node->path vectors
-        node_path_ms.index(nthreads, graph.get_node_count() + 1);
+        if (!in_memory) {
+            node_path_ms->index(nthreads, node_count + 1);
+        }
+        std::vector<uint64_t> np_starts(node_count + 1, 0);
+        for (uint64_t i = 0; i < node_count; ++i) {
+            np_starts[i + 1] = np_starts[i] + np_filled[i];
+        }
         sdsl::util::assign(nr_iv, sdsl::int_vector<>(np_size));
         sdsl::util::assign(np_bv, sdsl::bit_vector(np_size));
         sdsl::util::assign(npi_iv, sdsl::int_vector<>(np_size));
         // fill the node->path vectors
-        uint64_t  np_offset = 0;
-        for (int64_t i = 0; i < graph.get_node_count(); i++) {
-            np_bv[np_offset] = 1; // mark node start
-            uint64_t has_steps = false;
-            node_path_ms.for_values_of(i+1, [&](const std::tuple<uint64_t, uint64_t, uint64_t, uint64_t>& v) {
-                nr_iv[np_offset] = std::get<3>(v); // handle_rank_of_path
-                npi_iv[np_offset] = std::get<2>(v); // path id
-                has_steps = true;
-                np_offset++;
-            });
+        // nr_iv and npi_iv are still full width here, so threads never share a word
+#pragma omp parallel for schedule(static) num_threads(nthreads)
+        for (uint64_t i = 0; i < node_count; ++i) {
+            uint64_t np_offset = np_starts[i];
+            if (in_memory) {
+                // order the node's records as the multiset would
+                auto begin = node_path_records.begin() + np_slots[i];
+                auto end = begin + np_filled[i];
+                std::sort(begin, end);
+                for (auto it = begin; it != end; ++it) {
+                    nr_iv[np_offset] = it->handle_rank; // handle_rank_of_path
+                    npi_iv[np_offset] = it->path_id; // path id
+                    np_offset++;
+                }
+            } else {
+                node_path_ms->for_values_of(i+1, [&](const std::tuple<uint64_t, uint64_t, uint64_t, uint64_t>& v) {
+                    nr_iv[np_offset] = std::get<3>(v); // handle_rank_of_path
+                    npi_iv[np_offset] = std::get<2>(v); // path id
+                    np_offset++;
+                });
+            }
+        }
+        for (uint64_t i = 0; i < node_count; ++i) {
+            if (np_starts[i] < np_size) {
+                np_bv[np_starts[i]] = 1; // mark node start
+            }
         }
         sdsl::util::bit_compress(nr_iv);
         sdsl::util::bit_compress(npi_iv);
@@ -184,12 +264,16 @@ namespace xp {
         sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(s, name, sdsl::util::class_name(*this));
         size_t written = 0;
 
-        // Do the magic number
-        out << "XP";
+        // Do the magic number, which tells whether the nodes were remapped
+        out << (node_present.empty() ? "XP" : "XI");
         written += 2;
 
         // POSITION MAP STUFF
         written += pos_map_iv.serialize(out, child, "position_map");
+        if (!node_present.empty()) {
+            written += node_present.serialize(out, child, "node_present");
+            written += node_present_rank.serialize(out, child, "node_present_rank");
+        }
         // PATH STUFF
         written += sdsl::write_member(path_count, out, child, "path_count");
 
@@ -204,18 +288,31 @@ namespace xp {
         paths_written += pn_bv_select.serialize(out, paths_child, "path_names_starts_select");
         paths_written += pi_iv.serialize(out, paths_child, "path_ids");
 
+        // where each path record starts, and where the node->path vectors start after them
+        std::vector<uint64_t> record_offsets;
+        record_offsets.reserve(paths.size() + 1);
         for (size_t i = 0; i < paths.size(); i++) {
             XPPath *path = paths[i];
+            record_offsets.push_back(written + paths_written);
             paths_written += path->serialize(out, paths_child,
                                              "path:" + XP::get_path_name(handlegraph::as_path_handle(i + 1)));
         }
+        record_offsets.push_back(written + paths_written);
 
+        load_node_paths();
         paths_written += np_bv.serialize(out, paths_child, "node_path_mapping_starts");
         // paths_written += np_bv_rank.serialize(out, paths_child, "node_path_mapping_sarts_rank");
         // paths_written += np_bv_select.serialize(out, paths_child, "node_path_mapping_starts_select");
         paths_written += nr_iv.serialize(out, paths_child, "node_path_rank");
         paths_written += npi_iv.serialize(out, paths_child, "node_path_id");
 
+        // the record table lets load_mmap() find the paths without reading them
+        uint64_t record_count = paths.size();
+        out.write((char*)record_offsets.data(), record_offsets.size() * sizeof(uint64_t));
+        out.write((char*)&record_count, sizeof(record_count));
+        out.write((char*)&XP_RECORD_TABLE_MARKER, sizeof(XP_RECORD_TABLE_MARKER));
+        paths_written += (record_offsets.size() + 2) * sizeof(uint64_t);
+
         sdsl::structure_tree::add_size(paths_child, paths_written);
         written += paths_written;
 
@@ -228,7 +325,7 @@ namespace xp {
         load(in);
     }
 
-    void XP::load(std::istream &in) {
+    void XP::load_header(std::istream &in) {
 
         if (!in.good()) {
             throw XPFormatError("Index file does not exist or index stream cannot be read");
@@ -236,12 +333,16 @@ namespace xp {
 
         // We need to look for the magic value
         char buffer;
+        bool remapped = false;
         in.get(buffer);
         if (buffer == 'X') {
             in.get(buffer);
             if (buffer == 'P') {
                 // We found the magic value!
 
+            } else if (buffer == 'I') {
+                // an index of a graph whose node ids have gaps
+                remapped = true;
             } else {
                 // Put back both characters
                 in.unget();
@@ -252,15 +353,26 @@ namespace xp {
             in.unget();
         }
 
+        pos_map_iv.load(in);
+        if (remapped) {
+            node_present.load(in);
+            node_present_rank.load(in, &node_present);
+        } else {
+            sdsl::util::clear(node_present);
+            sdsl::util::clear(node_present_rank);
+        }
+        sdsl::read_member(path_count, in);
+        pn_iv.load(in);
+        pn_csa.load(in);
+        pn_bv.load(in);
+        pn_bv_rank.load(in, &pn_bv);
+        pn_bv_select.load(in, &pn_bv);
+        pi_iv.load(in);
+    }
+
+    void XP::load(std::istream &in) {
         try {
-            pos_map_iv.load(in);
-            sdsl::read_member(path_count, in);
-            pn_iv.load(in);
-            pn_csa.load(in);
-            pn_bv.load(in);
-            pn_bv_rank.load(in, &pn_bv);
-            pn_bv_select.load(in, &pn_bv);
-            pi_iv.load(in);
+            load_header(in);
 
             for (size_t i = 0; i < path_count; ++i) {
                 auto path = new XPPath;
@@ -276,6 +388,10 @@ namespace xp {
             // np_bv_select.load(in, &np_bv);
             nr_iv.load(in);
             npi_iv.load(in);
+            // indexes written since the record table was added end with it
+            if (in.peek() != std::char_traits<char>::eof()) {
+                in.ignore((path_count + 3) * sizeof(uint64_t));
+            }
 #ifdef debug_load
             std::cerr << "np_bv: ";
             for (uint64_t i = 0; i < np_bv.size(); i++) {
@@ -307,6 +423,78 @@ namespace xp {
         }
     }
 
+    void XP::load_mmap(const std::string &filename) {
+        std::error_code error;
+        mapped_file = mio::make_mmap_source(filename, error);
+        if (error) {
+            throw XPFormatError("Index file " + filename + " cannot be mapped: " + error.message());
+        }
+        const char* begin = mapped_file.data();
+        const char* end = begin + mapped_file.size();
+        // the record table ends with the path count and its marker
+        uint64_t marker = 0;
+        uint64_t record_count = 0;
+        uint64_t table_bytes = 0;
+        if (mapped_file.size() >= 2 + 3 * sizeof(uint64_t)) {
+            std::memcpy(&marker, end - sizeof(uint64_t), sizeof(marker));
+            std::memcpy(&record_count, end - 2 * sizeof(uint64_t), sizeof(record_count));
+            table_bytes = (record_count + 3) * sizeof(uint64_t);
+        }
+        if (marker != XP_RECORD_TABLE_MARKER || record_count >= mapped_file.size() / sizeof(uint64_t)
+            || table_bytes > mapped_file.size() - 2) {
+            // written before the record table existed, so there is nothing to map in place
+            // the stream reads the mapping, so it stays mapped until the index is loaded
+            odgi::imemstream in(begin, end);
+            load(in);
+            mapped_file.unmap();
+            return;
+        }
+        const char* table = end - table_bytes;
+        std::vector<uint64_t> record_offsets(record_count + 1);
+        std::memcpy(record_offsets.data(), table, record_offsets.size() * sizeof(uint64_t));
+        for (size_t i = 0; i < record_count; ++i) {
+            if (record_offsets[i] > record_offsets[i + 1]) {
+                throw XPFormatError("Index file " + filename + " has a corrupt path record table");
+            }
+        }
+        if (record_offsets[record_count] > (uint64_t)(table - begin)) {
+            throw XPFormatError("Index file " + filename + " has a corrupt path record table");
+        }
+        try {
+            // the position map and path names are small, so we decode them
+            odgi::imemstream in(begin, begin + record_offsets[0]);
+            load_header(in);
+        } catch (const std::bad_alloc &e) {
+            throw XPFormatError("XP input data not in XP format (" + std::string(e.what()) + ")");
+        }
+        if (path_count != record_count) {
+            throw XPFormatError("Index file " + filename + " has " + std::to_string(path_count)
+                                + " paths but " + std::to_string(record_count) + " path records");
+        }
+        for (size_t i = 0; i < path_count; ++i) {
+            auto path = new XPPath;
+            path->map(begin + record_offsets[i], begin + record_offsets[i + 1]);
+            paths.push_back(path);
+        }
+        node_paths_begin = begin + record_offsets[record_count];
+        node_paths_end = table;
+        const char* next = mapped_np_bv.map(node_paths_begin, node_paths_end, 1);
+        next = mapped_nr_iv.map(next, node_paths_end);
+        mapped_npi_iv.map(next, node_paths_end);
+        node_paths_pending.store(true, std::memory_order_release);
+    }
+
+    void XP::load_node_paths() const {
+        if (!node_paths_pending.load(std::memory_order_acquire)) return;
+        std::lock_guard<std::mutex> guard(node_paths_lock);
+        if (!node_paths_pending.load(std::memory_order_relaxed)) return;
+        odgi::imemstream in(node_paths_begin, node_paths_end);
+        np_bv.load(in);
+        nr_iv.load(in);
+        npi_iv.load(in);
+        node_paths_pending.store(false, std::memory_order_release);
+    }
+
     void XP::clean() {
         // Clean up any created XPPaths
         while (!paths.empty()) {
@@ -314,9 +502,328 @@ namespace xp {
             paths.pop_back();
         }
         path_count = 0;
+        pn_mphf.reset();
+        pn_mphf_slots.clear();
+        sdsl::util::clear(ns_bv);
+        sdsl::util::clear(ns_bv_select);
+        ns_path_ranks.clear();
+        sdsl::util::clear(node_present);
+        sdsl::util::clear(node_present_rank);
+        // the paths may have pointed into the mapping
+        node_paths_pending.store(false);
+        node_paths_begin = node_paths_end = nullptr;
+        mapped_np_bv = mapped_nr_iv = mapped_npi_iv = mapped_int_vector();
+        mapped_file.unmap();
     }
 
-    bool XP::has_path(const std::string& path_name) const {
+    void XP::set_path_names(const std::string& path_names, const std::string& path_name_file) {
+        sdsl::util::assign(pn_iv, sdsl::int_vector<>(path_names.size()));
+        sdsl::util::assign(pn_bv, sdsl::bit_vector(path_names.size()));
+        // now record path name starts
+        for (size_t i = 0; i < path_names.size(); ++i) {
+            pn_iv[i] = path_names[i];
+            if (path_names[i] == start_marker) {
+                pn_bv[i] = 1; // register name start
+            }
+        }
+        sdsl::util::assign(pn_bv_rank, sdsl::rank_support_v<1>(&pn_bv));
+        sdsl::util::assign(pn_bv_select, sdsl::bit_vector::select_1_type(&pn_bv));
+
+        // write path names to temp file
+        sdsl::store_to_file((const char *) path_names.c_str(), path_name_file);
+        // read file and construct compressed suffix array
+        sdsl::construct(pn_csa, path_name_file, 1);
+    }
+
+    std::vector<const XPPath *> XP::paths_by_graph_id(const PathHandleGraph &graph) const {
+        std::vector<const XPPath *> path_of_id;
+        for (uint64_t rank = 1; rank <= path_count; ++rank) {
+            std::string name = get_path_name(as_path_handle(rank));
+            if (!graph.has_path(name)) {
+                throw std::runtime_error("[xp] error: the indexed path " + name + " is not in the graph");
+            }
+            uint64_t id = as_integer(graph.get_path_handle(name));
+            if (id >= path_of_id.size()) {
+                path_of_id.resize(id + 1, nullptr);
+            }
+            path_of_id[id] = paths[rank - 1];
+        }
+        return path_of_id;
+    }
+
+    void XP::merge_node_paths(const std::vector<const XPPath *>& path_of_id,
+                              std::vector<std::tuple<uint64_t, uint64_t, uint64_t, uint64_t>>& added,
+                              const std::vector<uint64_t>& removed) {
+        uint64_t node_count = pos_map_iv.size() - 1;
+        // the old records are in node order, and each one's node is that of the step it points to
+        std::vector<uint64_t> old_counts(node_count, 0);
+        for (uint64_t j = 0; j < npi_iv.size(); ++j) {
+            uint64_t path_id = npi_iv[j];
+            if (path_id >= path_of_id.size() || path_of_id[path_id] == nullptr) {
+                throw std::runtime_error("[xp] error: the index has a step on a path that is not in the graph");
+            }
+            handle_t h = path_of_id[path_id]->handle(nr_iv[j] - 1);
+            ++old_counts[node_rank(number_bool_packing::unpack_number(h))];
+        }
+        // the added records are [node rank, step_rank, path_id, rank_of_handle_in_path], and new steps on
+        // a node have higher step ranks than the ones already there, so they go after them
+        std::sort(added.begin(), added.end());
+        std::vector<uint64_t> np_starts(node_count + 1, 0);
+        std::vector<uint64_t> nr, npi;
+        nr.reserve(npi_iv.size() + added.size());
+        npi.reserve(npi_iv.size() + added.size());
+        uint64_t old_offset = 0;
+        auto next_added = added.begin();
+        for (uint64_t i = 0; i < node_count; ++i) {
+            np_starts[i] = nr.size();
+            for (uint64_t j = old_offset; j < old_offset + old_counts[i]; ++j) {
+                if (!std::binary_search(removed.begin(), removed.end(), (uint64_t)npi_iv[j])) {
+                    nr.push_back(nr_iv[j]);
+                    npi.push_back(npi_iv[j]);
+                }
+            }
+            old_offset += old_counts[i];
+            for ( ; next_added != added.end() && std::get<0>(*next_added) == i; ++next_added) {
+                nr.push_back(std::get<3>(*next_added));
+                npi.push_back(std::get<2>(*next_added));
+            }
+        }
+        sdsl::util::assign(nr_iv, sdsl::int_vector<>(nr.size()));
+        sdsl::util::assign(np_bv, sdsl::bit_vector(nr.size()));
+        sdsl::util::assign(npi_iv, sdsl::int_vector<>(npi.size()));
+        for (uint64_t j = 0; j < nr.size(); ++j) {
+            nr_iv[j] = nr[j];
+            npi_iv[j] = npi[j];
+        }
+        for (uint64_t i = 0; i < node_count; ++i) {
+            if (np_starts[i] < nr.size()) {
+                np_bv[np_starts[i]] = 1; // mark node start
+            }
+        }
+        sdsl::util::bit_compress(nr_iv);
+        sdsl::util::bit_compress(npi_iv);
+    }
+
+    void XP::add_paths(const PathHandleGraph &graph, const std::vector<path_handle_t>& new_paths, const uint64_t& nthreads) {
+        if (graph.get_node_count() + 1 != pos_map_iv.size()) {
+            throw std::runtime_error("[xp] error: paths can only be added to an index of the same nodes; please rebuild it");
+        }
+        load_node_paths();
+        std::vector<const XPPath *> path_of_id = paths_by_graph_id(graph);
+        // index the new paths on their own, as the builder does
+        std::vector<XPPath *> added_paths(new_paths.size());
+        std::vector<std::vector<std::tuple<uint64_t, uint64_t, uint64_t, uint64_t>>> added_by_path(new_paths.size());
+#pragma omp parallel for schedule(dynamic,1) num_threads(nthreads)
+        for (uint64_t i = 0; i < new_paths.size(); ++i) {
+            const path_handle_t& path = new_paths[i];
+            std::vector<handle_t> p;
+            uint64_t handle_rank_in_path = 0;
+            graph.for_each_step_in_path(path, [&](const step_handle_t &occ) {
+                handle_t h = graph.get_handle_of_step(occ);
+                p.push_back(h);
+                ++handle_rank_in_path; // handle ranks in path are 1-based
+                added_by_path[i].push_back(std::make_tuple(node_rank(number_bool_packing::unpack_number(h)),
+                                                           as_integers(occ)[1], as_integer(path), handle_rank_in_path));
+            });
+            added_paths[i] = new XPPath(graph.get_path_name(path), p, false, graph);
+        }
+        std::vector<std::tuple<uint64_t, uint64_t, uint64_t, uint64_t>> added;
+        for (auto& records : added_by_path) {
+            added.insert(added.end(), records.begin(), records.end());
+        }
+        merge_node_paths(path_of_id, added, std::vector<uint64_t>());
+        // the names are a small part of the index, so we simply rebuild them
+        std::string path_names;
+        for (uint64_t rank = 1; rank <= path_count; ++rank) {
+            path_names += start_marker + get_path_name(as_path_handle(rank)) + end_marker;
+        }
+        for (auto& path : new_paths) {
+            path_names += start_marker + graph.get_path_name(path) + end_marker;
+        }
+        paths.insert(paths.end(), added_paths.begin(), added_paths.end());
+        path_count = paths.size();
+        std::string path_name_file = temp_file::create();
+        set_path_names(path_names, path_name_file);
+        temp_file::remove(path_name_file);
+        if (pn_mphf) {
+            index_path_names(nthreads);
+        }
+        if (has_node_step_index()) {
+            index_node_steps(graph, nthreads);
+        }
+    }
+
+    void XP::remove_paths(const PathHandleGraph &graph, const std::vector<path_handle_t>& removed_paths, const uint64_t& nthreads) {
+        if (graph.get_node_count() + 1 != pos_map_iv.size()) {
+            throw std::runtime_error("[xp] error: paths can only be removed from an index of the same nodes; please rebuild it");
+        }
+        load_node_paths();
+        // the node->path records name the paths by their handle in the graph
+        std::vector<uint64_t> removed;
+        std::vector<bool> removed_ranks(path_count + 1, false);
+        for (auto& path : removed_paths) {
+            uint64_t rank = get_path_rank(graph.get_path_name(path));
+            if (rank == 0) {
+                throw std::runtime_error("[xp] error: the path " + graph.get_path_name(path) + " is not in the index");
+            }
+            removed_ranks[rank] = true;
+            removed.push_back(as_integer(path));
+        }
+        std::sort(removed.begin(), removed.end());
+        std::vector<std::tuple<uint64_t, uint64_t, uint64_t, uint64_t>> added;
+        merge_node_paths(paths_by_graph_id(graph), added, removed);
+        // keep the other paths in their order, which later ones move up in
+        std::string path_names;
+        std::vector<XPPath *> kept_paths;
+        for (uint64_t rank = 1; rank <= path_count; ++rank) {
+            if (removed_ranks[rank]) {
+                delete paths[rank - 1];
+            } else {
+                path_names += start_marker + get_path_name(as_path_handle(rank)) + end_marker;
+                kept_paths.push_back(paths[rank - 1]);
+            }
+        }
+        paths = kept_paths;
+        path_count = paths.size();
+        std::string path_name_file = temp_file::create();
+        set_path_names(path_names, path_name_file);
+        temp_file::remove(path_name_file);
+        if (pn_mphf) {
+            index_path_names(nthreads);
+        }
+        if (has_node_step_index()) {
+            index_node_steps(graph, nthreads);
+        }
+    }
+
+    void XP::index_path_names(const uint64_t& nthreads) {
+        pn_mphf.reset();
+        pn_mphf_slots.clear();
+        if (path_count == 0) {
+            return;
+        }
+        std::vector<uint64_t> hashes(path_count);
+        for (uint64_t rank = 1; rank <= path_count; ++rank) {
+            hashes[rank - 1] = std::hash<std::string>()(get_path_name(as_path_handle(rank)));
+        }
+        // the hash needs distinct keys; if two names collide we keep searching the csa
+        std::vector<uint64_t> keys = hashes;
+        std::sort(keys.begin(), keys.end());
+        if (std::adjacent_find(keys.begin(), keys.end()) != keys.end()) {
+            return;
+        }
+        pn_mphf.reset(new boophf_path_name_t(keys.size(), keys, nthreads, 2.0, false, false));
+        pn_mphf_slots.resize(path_count);
+        for (uint64_t rank = 1; rank <= path_count; ++rank) {
+            pn_mphf_slots[pn_mphf->lookup(hashes[rank - 1])] = std::make_pair(rank, hashes[rank - 1]);
+        }
+    }
+
+    bool XP::has_path_name_index() const {
+        return pn_mphf != nullptr;
+    }
+
+    void XP::index_node_steps(const PathHandleGraph &graph, const uint64_t& nthreads) {
+        const mapped_int_vector nr_iv = get_nr_iv_view();
+        const mapped_int_vector npi_iv = get_npi_iv_view();
+        // path id 0 is never used, which keeps an indexed empty index apart from an unindexed one
+        ns_path_ranks.assign(1, 0);
+        for (uint64_t rank = 1; rank <= path_count; ++rank) {
+            std::string name = get_path_name(as_path_handle(rank));
+            if (!graph.has_path(name)) {
+                ns_path_ranks.clear();
+                throw std::runtime_error("[xp] error: the indexed path " + name + " is not in the graph");
+            }
+            uint64_t id = as_integer(graph.get_path_handle(name));
+            if (id >= ns_path_ranks.size()) {
+                ns_path_ranks.resize(id + 1, 0);
+            }
+            ns_path_ranks[id] = rank;
+        }
+        // the records are in node order, so each node's are those between the first records
+        // on it and on the next node; a record's node is that of the step it points to
+        const uint64_t node_count = pos_map_iv.size() - 1;
+        const uint64_t record_count = npi_iv.size();
+        std::atomic<bool> unknown_path(false);
+        auto node_of_record = [&](uint64_t j) -> uint64_t {
+            uint64_t path_id = npi_iv[j];
+            if (path_id >= ns_path_ranks.size() || ns_path_ranks[path_id] == 0) {
+                unknown_path.store(true);
+                return 0;
+            }
+            handle_t h = paths[ns_path_ranks[path_id] - 1]->handle(nr_iv[j] - 1);
+            return node_rank(number_bool_packing::unpack_number(h));
+        };
+        std::vector<uint64_t> first_record(node_count + 1, record_count);
+#pragma omp parallel for schedule(static) num_threads(nthreads)
+        for (uint64_t j = 0; j < record_count; ++j) {
+            uint64_t node = node_of_record(j);
+            uint64_t prev_node = j == 0 ? 0 : node_of_record(j - 1) + 1;
+            for (uint64_t i = prev_node; i <= node; ++i) {
+                first_record[i] = j;
+            }
+        }
+        if (unknown_path.load()) {
+            ns_path_ranks.clear();
+            throw std::runtime_error("[xp] error: the index has a step on a path that is not in the graph");
+        }
+        sdsl::util::assign(ns_bv, sdsl::bit_vector(record_count + node_count));
+        for (uint64_t i = 0; i < node_count; ++i) {
+            ns_bv[first_record[i + 1] + i] = 1; // close node i
+        }
+        sdsl::util::assign(ns_bv_select, sdsl::bit_vector::select_1_type(&ns_bv));
+    }
+
+    bool XP::has_node_step_index() const {
+        return !ns_path_ranks.empty();
+    }
+
+    bool XP::for_each_step_on_handle(const handle_t& handle,
+                                     const std::function<bool(const step_handle_t&)>& iteratee) const {
+        if (!has_node_step_index()) {
+            throw std::runtime_error("[xp] error: the steps on the nodes are not indexed; please run index_node_steps() first");
+        }
+        uint64_t rank = node_rank(number_bool_packing::unpack_number(handle));
+        uint64_t begin = rank == 0 ? 0 : ns_bv_select(rank) - (rank - 1);
+        uint64_t end = ns_bv_select(rank + 1) - rank;
+        const mapped_int_vector nr_iv = get_nr_iv_view();
+        const mapped_int_vector npi_iv = get_npi_iv_view();
+        for (uint64_t j = begin; j < end; ++j) {
+            step_handle_t step;
+            as_integers(step)[0] = ns_path_ranks[npi_iv[j]];
+            as_integers(step)[1] = nr_iv[j] - 1;
+            if (!iteratee(step)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool XP::path_name_equals(uint64_t rank, const std::string& path_name) const {
+        size_t start = pn_bv_select(rank) + 1; // step past '#'
+        size_t end = (rank == path_count ? pn_iv.size() : pn_bv_select(rank + 1)) - 1; // step before '$'
+        if (end - start != path_name.size()) {
+            return false;
+        }
+        for (size_t i = start; i < end; ++i) {
+            if ((char)pn_iv[i] != path_name[i - start]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint64_t XP::get_path_rank(const std::string& path_name) const {
+        if (pn_mphf) {
+            // names not in the index hash to an arbitrary slot, so check what we find there
+            uint64_t hash = std::hash<std::string>()(path_name);
+            uint64_t slot = pn_mphf->lookup(hash);
+            if (slot >= pn_mphf_slots.size() || pn_mphf_slots[slot].second != hash
+                || !path_name_equals(pn_mphf_slots[slot].first, path_name)) {
+                return 0;
+            }
+            return pn_mphf_slots[slot].first;
+        }
         // find the name in the csa
         std::string query = start_marker + path_name + end_marker;
         auto occs = locate(pn_csa, query);
@@ -324,40 +831,36 @@ namespace xp {
             std::cerr << "error [xp]: multiple hits for " << query << std::endl;
             exit(1);
         }
-        return !(occs.size() == 0);
+        if (occs.size() == 0) {
+            return 0;
+        }
+        return pn_bv_rank(occs[0]) + 1; // step past '#'
+    }
+
+    bool XP::has_path(const std::string& path_name) const {
+        return get_path_rank(path_name) != 0;
     }
 
     bool XP::has_position(const std::string& path_name, size_t nuc_pos) const {
         if (has_path(path_name)) {
             const XPPath& xppath = get_path(path_name);
-            return xppath.offsets.size() > nuc_pos;
+            return xppath.length() > nuc_pos;
         } else {
             return false;
         }
     }
 
     path_handle_t XP::get_path_handle(const std::string& path_name) const {
-        // find the name in the csa
-        std::string query = start_marker + path_name + end_marker;
-        auto occs = locate(pn_csa, query);
-        if (occs.size() > 1) {
-            std::cerr << "error [xp]: multiple hits for " << query << std::endl;
-            exit(1);
-        }
-        if(occs.size() == 0) {
-            // This path does not exist. Give back 0, which can never be a real path
-            // rank.
-            return as_path_handle(0);
-        }
-        return as_path_handle(pn_bv_rank(occs[0])+1); // step past '#'
+        // If the path does not exist we give back 0, which can never be a real path rank.
+        return as_path_handle(get_path_rank(path_name));
     }
 
     size_t XP::get_path_length(const path_handle_t& path_handle) const {
-        return paths[as_integer(path_handle) - 1]->offsets.size();
+        return paths[as_integer(path_handle) - 1]->length();
     }
 
     size_t XP::get_path_step_count(const handlegraph::path_handle_t& path_handle) const {
-        return paths[as_integer(path_handle) - 1]->handles.size();
+        return paths[as_integer(path_handle) - 1]->step_count();
     }
 
     /// Get the step at a given position
@@ -377,7 +880,7 @@ namespace xp {
     size_t XP::get_position_of_step(const step_handle_t& step_handle) const {
         const auto& xppath = *paths[as_integer(get_path_handle_of_step(step_handle)) - 1];
         auto& step_rank = as_integers(step_handle)[1];
-        return xppath.positions[step_rank];
+        return xppath.position(step_rank);
     }
 
     path_handle_t XP::get_path_handle_of_step(const step_handle_t& step_handle) const {
@@ -403,6 +906,7 @@ namespace xp {
     }
 
     const sdsl::int_vector<>& XP::get_nr_iv() const {
+        load_node_paths();
         return nr_iv;
     }
 /*
@@ -411,13 +915,39 @@ namespace xp {
     }
 */
 
-    const sdsl::bit_vector XP::get_np_bv() const {
+    const sdsl::bit_vector& XP::get_np_bv() const {
+        load_node_paths();
         return np_bv;
     }
 
     const sdsl::int_vector<>& XP::get_npi_iv() const {
+        load_node_paths();
         return npi_iv;
     }
+
+    mapped_int_vector XP::get_np_bv_view() const {
+        mapped_int_vector view = mapped_np_bv;
+        if (!node_paths_pending.load(std::memory_order_acquire)) {
+            view.view(np_bv);
+        }
+        return view;
+    }
+
+    mapped_int_vector XP::get_nr_iv_view() const {
+        mapped_int_vector view = mapped_nr_iv;
+        if (!node_paths_pending.load(std::memory_order_acquire)) {
+            view.view(nr_iv);
+        }
+        return view;
+    }
+
+    mapped_int_vector XP::get_npi_iv_view() const {
+        mapped_int_vector view = mapped_npi_iv;
+        if (!node_paths_pending.load(std::memory_order_acquire)) {
+            view.view(npi_iv);
+        }
+        return view;
+    }
 /*
     const sdsl::rank_support_v<1> XP::get_np_bv_rank() const {
         return np_bv_rank;
@@ -441,7 +971,7 @@ namespace xp {
         }
         const XPPath& xppath = get_path(path_name);
         // Is the nucleotide position there?!
-        if (xppath.offsets.size() <= nuc_pos) {
+        if (xppath.length() <= nuc_pos) {
             std::cerr << "[XP] error: The given path " << path_name << " with nucleotide position " << nuc_pos << " is not in the index." << std::endl;
             exit(1);
         }
@@ -458,12 +988,12 @@ namespace xp {
         // p = as_handle(as_integer(p) + 1);
 
         // handle position
-        uint64_t handle_pos = pos_map_iv[number_bool_packing::unpack_number(p)];
+        uint64_t handle_pos = pos_map_iv[node_rank(number_bool_packing::unpack_number(p))];
 #ifdef debug_get_pangenome_pos
         std::cerr << "[GET_PANGENOME_POS]: handle_pos: " << handle_pos << std::endl;
 #endif
         // length of the handle
-        uint64_t next_handle_pos = pos_map_iv[number_bool_packing::unpack_number(p) + 1];
+        uint64_t next_handle_pos = pos_map_iv[node_rank(number_bool_packing::unpack_number(p)) + 1];
 #ifdef debug_get_pangenome_pos
         std::cerr << "[GET_PANGENOME_POS]: next_handle_pos: " << next_handle_pos << std::endl;
 #endif
@@ -475,9 +1005,10 @@ namespace xp {
         // Adjust this for both strands!!!
         size_t step_rank = xppath.step_rank_at_position(nuc_pos);
 #ifdef debug_get_pangenome_pos
-        std::cerr << "[GET_PANGENOME_POS]: offset_in_handle: " << xppath.offsets_select(step_rank+1) << std::endl;
+        std::cerr << "[GET_PANGENOME_POS]: offset_in_handle: " << xppath.position(step_rank) << std::endl;
 #endif
-        uint64_t offset_in_handle = nuc_pos - xppath.offsets_select(step_rank+1);
+        // the step starts where its offset bit is set, which the positions record directly
+        uint64_t offset_in_handle = nuc_pos - xppath.position(step_rank);
 #ifdef debug_get_pangenome_pos
         std::cerr << "[GET_PANGENOME_POS]: offset_in_handle: " << offset_in_handle << std::endl;
 #endif
@@ -500,19 +1031,119 @@ namespace xp {
         return pos_in_pangenome;
     }
 
+    size_t XP::get_pangenome_pos_on_step(const XPPath& xppath, size_t step_rank, size_t nuc_pos) const {
+        handle_t p = xppath.handle(step_rank);
+        uint64_t rank = node_rank(number_bool_packing::unpack_number(p));
+        uint64_t handle_pos = pos_map_iv[rank];
+        uint64_t node_length = pos_map_iv[rank + 1] - handle_pos;
+        uint64_t offset_in_handle = nuc_pos - xppath.position(step_rank);
+        if (number_bool_packing::unpack_bit(p)) {
+            offset_in_handle = node_length - offset_in_handle - 1;
+        }
+        return handle_pos + offset_in_handle;
+    }
+
+    void XP::get_pangenome_positions(const std::vector<std::pair<std::string, size_t>>& queries,
+                                     std::vector<size_t>& results,
+                                     const uint64_t& nthreads) const {
+        results.assign(queries.size(), XP_NO_PANGENOME_POS);
+        // resolve each distinct path name once, keeping (path rank, position, query) triples
+        std::unordered_map<std::string, uint64_t> path_ranks;
+        std::vector<std::tuple<uint64_t, size_t, uint64_t>> sorted_queries;
+        sorted_queries.reserve(queries.size());
+        for (uint64_t i = 0; i < queries.size(); ++i) {
+            auto f = path_ranks.find(queries[i].first);
+            if (f == path_ranks.end()) {
+                f = path_ranks.emplace(queries[i].first, get_path_rank(queries[i].first)).first;
+            }
+            if (f->second != 0) {
+                sorted_queries.push_back(std::make_tuple(f->second, queries[i].second, i));
+            }
+        }
+        ips4o::parallel::sort(sorted_queries.begin(), sorted_queries.end(), std::less<>(), nthreads);
+        // each path's queries form one run
+        std::vector<uint64_t> run_starts;
+        for (uint64_t i = 0; i < sorted_queries.size(); ++i) {
+            if (i == 0 || std::get<0>(sorted_queries[i]) != std::get<0>(sorted_queries[i - 1])) {
+                run_starts.push_back(i);
+            }
+        }
+        run_starts.push_back(sorted_queries.size());
+#pragma omp parallel for schedule(dynamic,1) num_threads(nthreads)
+        for (uint64_t r = 0; r < run_starts.size() - 1; ++r) {
+            const XPPath& xppath = *paths[std::get<0>(sorted_queries[run_starts[r]]) - 1];
+            const size_t path_length = xppath.length();
+            const size_t step_count = xppath.step_count();
+            size_t step_rank = 0;
+            bool started = false;
+            for (uint64_t i = run_starts[r]; i < run_starts[r + 1]; ++i) {
+                const size_t nuc_pos = std::get<1>(sorted_queries[i]);
+                if (nuc_pos >= path_length) {
+                    break; // so are all the ones after it
+                }
+                if (!started) {
+                    step_rank = xppath.step_rank_at_position(nuc_pos);
+                    started = true;
+                } else {
+                    // walk to nearby steps, and search for ones further along
+                    uint64_t walked = 0;
+                    while (step_rank + 1 < step_count && xppath.position(step_rank + 1) <= nuc_pos) {
+                        if (++walked > 8) {
+                            step_rank = xppath.step_rank_at_position(nuc_pos);
+                            break;
+                        }
+                        ++step_rank;
+                    }
+                }
+                results[std::get<2>(sorted_queries[i])] = get_pangenome_pos_on_step(xppath, step_rank, nuc_pos);
+            }
+        }
+    }
+
     ////////////////////////////////////////////////////////////////////////////
     // Here is XPPath
     ////////////////////////////////////////////////////////////////////////////
 
     size_t XPPath::step_rank_at_position(size_t pos) const {
+        if (mapped) {
+            // the last step starting at or before pos
+            size_t lo = 0;
+            size_t hi = mapped_positions.size();
+            while (hi - lo > 1) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (mapped_positions[mid] <= pos) {
+                    lo = mid;
+                } else {
+                    hi = mid;
+                }
+            }
+            return lo;
+        }
         return offsets_rank(pos + 1) - 1;
     }
 
+    size_t XPPath::step_count() const {
+        return mapped ? mapped_handles.size() : handles.size();
+    }
+
+    size_t XPPath::length() const {
+        return mapped ? mapped_length : offsets.size();
+    }
+
+    size_t XPPath::position(size_t rank) const {
+        return mapped ? mapped_positions[rank] : positions[rank];
+    }
+
     size_t XPPath::serialize(std::ostream &out,
                              sdsl::structure_tree_node *v,
                              std::string name) const {
         sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
         size_t written = 0;
+        if (mapped) {
+            out.write(mapped_record, mapped_record_size);
+            sdsl::structure_tree::add_size(child, mapped_record_size);
+            return mapped_record_size;
+        }
         written += sdsl::write_member(min_handle, out, child, "min_handle" + name);
         written += handles.serialize(out, child, "path_handles_" + name);
         written += positions.serialize(out, child, "path_positions_" + name);
@@ -662,6 +1293,49 @@ namespace xp {
 #endif
     }
 
+    void XPPath::map(const char* begin, const char* end) {
+        // the record holds min_handle, handles, positions and offsets, then the
+        // rank and select supports for offsets, which we can do without, and is_circular
+        if (end - begin < (int64_t)(sizeof(min_handle) + sizeof(is_circular))) {
+            throw XPFormatError("XP path record is truncated");
+        }
+        std::memcpy(&min_handle, begin, sizeof(min_handle));
+        const char* p = begin + sizeof(min_handle);
+        p = mapped_handles.map(p, end);
+        p = mapped_positions.map(p, end);
+        if (end - p < (int64_t)sizeof(uint64_t)) {
+            throw XPFormatError("XP path record is truncated");
+        }
+        std::memcpy(&mapped_length, p, sizeof(mapped_length));
+        std::memcpy(&is_circular, end - sizeof(is_circular), sizeof(is_circular));
+        mapped_record = begin;
+        mapped_record_size = end - begin;
+        mapped = true;
+    }
+
+    const char* mapped_int_vector::map(const char* data, const char* end, uint8_t fixed_width) {
+        uint64_t bits = 0;
+        if (end - data < (int64_t)sizeof(bits) + (fixed_width ? 0 : 1)) {
+            throw XPFormatError("XP vector header is truncated");
+        }
+        std::memcpy(&bits, data, sizeof(bits));
+        data += sizeof(bits);
+        width = fixed_width;
+        if (!width) {
+            width = (uint8_t)*data++;
+        }
+        if (width == 0 || width > 64) {
+            throw XPFormatError("XP vector has an invalid width of " + std::to_string(width));
+        }
+        count = bits / width;
+        words = data;
+        uint64_t bytes = ((bits + 63) / 64) * sizeof(uint64_t);
+        if ((uint64_t)(end - data) < bytes) {
+            throw XPFormatError("XP vector is truncated");
+        }
+        return data + bytes;
+    }
+
     handle_t XPPath::local_handle(const handle_t &handle) const {
         if (as_integer(handle) < as_integer(min_handle)) {
             throw std::runtime_error("Handle with value " + std::to_string(as_integer(handle)) +
@@ -673,7 +1347,7 @@ namespace xp {
     }
 
     handle_t XPPath::handle(size_t offset) const {
-        return external_handle(as_handle(handles[offset]));
+        return external_handle(as_handle(mapped ? mapped_handles[offset] : handles[offset]));
     }
 
     handle_t XPPath::external_handle(const handle_t& handle) const {
@@ -3,6 +3,12 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstring>
+#include <atomic>
+#include <memory>
+#include <limits>
+#include <tuple>
+#include <vector>
 #include <dirent.h>
 #include <omp.h>
 
@@ -15,7 +21,9 @@
 #include "handlegraph/handle_graph.hpp"
 #include "handlegraph/path_position_handle_graph.hpp"
 #include "mmmultimap.hpp"
+#include "BooPHF.h"
 #include "odgi.hpp"
+#include <mio/mmap.hpp>
 #include <arpa/inet.h>
 #include "mutex"
 
@@ -38,6 +46,62 @@ namespace xp {
         using std::runtime_error::runtime_error;
     };
 
+    /// Where the node->path records are sorted while building an index
+    enum class node_path_sort_t {
+        automatic, ///< in memory when they fit in half the free memory, else on disk
+        in_memory, ///< a counting sort by node id in RAM
+        on_disk    ///< a temporary mmmulti map
+    };
+
+    typedef boomphf::mphf<uint64_t, boomphf::SingleHashFunctor<uint64_t>> boophf_path_name_t;
+
+    /// The pangenome position given for queries that are not in the index
+    const size_t XP_NO_PANGENOME_POS = std::numeric_limits<size_t>::max();
+
+    /// Ends the table of path record offsets written after an index
+    const uint64_t XP_RECORD_TABLE_MARKER = 0x5450585045434f52; // "ROCEPXPT"
+
+    /**
+     * A read-only view of an sdsl::int_vector as serialized in a mapped file, or
+     * of one in memory.
+     */
+    class mapped_int_vector {
+    public:
+        /// Point at the vector serialized at data. Vectors of a fixed width, like
+        /// bit vectors, are written without their width. Returns the end of the vector.
+        const char* map(const char* data, const char* end, uint8_t fixed_width = 0);
+
+        /// Point at a vector in memory, which must outlive this view.
+        template<uint8_t t_width>
+        void view(const sdsl::int_vector<t_width>& vector) {
+            words = (const char*)vector.data();
+            count = vector.size();
+            width = vector.width();
+        }
+
+        inline uint64_t operator[](uint64_t i) const {
+            uint64_t bit = i * width;
+            const char* word = words + (bit >> 6) * sizeof(uint64_t);
+            uint64_t shift = bit & 63;
+            uint64_t lo;
+            std::memcpy(&lo, word, sizeof(lo));
+            uint64_t value = lo >> shift;
+            if (shift + width > 64) {
+                uint64_t hi;
+                std::memcpy(&hi, word + sizeof(uint64_t), sizeof(hi));
+                value |= hi << (64 - shift);
+            }
+            return width == 64 ? value : value & ((1ULL << width) - 1);
+        }
+
+        inline uint64_t size() const { return count; }
+
+    private:
+        const char* words = nullptr;
+        uint64_t count = 0;
+        uint8_t width = 0;
+    };
+
     /**
     * Provides succinct storage for the positional paths of a graph.
     */
@@ -67,11 +131,26 @@ namespace xp {
         ////////////////////////////////////////////////////////////////////////////
 
         /// Build the path index from a simple graph.
-        void from_handle_graph(const handlegraph::PathHandleGraph &graph, const uint64_t& nthreads);
-        void from_handle_graph(const handlegraph::PathHandleGraph &graph, std::string basename, const uint64_t& nthreads);
+        void from_handle_graph(const handlegraph::PathHandleGraph &graph, const uint64_t& nthreads,
+                               const node_path_sort_t node_path_sort = node_path_sort_t::automatic);
+        void from_handle_graph(const handlegraph::PathHandleGraph &graph, std::string basename, const uint64_t& nthreads,
+                               const node_path_sort_t node_path_sort = node_path_sort_t::automatic);
 
         /// helper to builder
-        void from_handle_graph_impl(const handlegraph::PathHandleGraph &graph, const std::string& basename, const uint64_t& nthreads);
+        void from_handle_graph_impl(const handlegraph::PathHandleGraph &graph, const std::string& basename, const uint64_t& nthreads,
+                                    const node_path_sort_t node_path_sort);
+
+        /// Index paths that were added to the graph since this index was built. Only the
+        /// new paths are walked; the node->path vectors are merged with their steps in one
+        /// linear pass and the path names, which are small, are rebuilt. The graph must
+        /// have the same nodes as when the index was built.
+        void add_paths(const handlegraph::PathHandleGraph &graph, const std::vector<handlegraph::path_handle_t>& new_paths,
+                       const uint64_t& nthreads = 1);
+
+        /// Drop paths from the index. Call this before the paths are destroyed in the graph.
+        /// The paths after them move up, so their path handles in the index change.
+        void remove_paths(const handlegraph::PathHandleGraph &graph, const std::vector<handlegraph::path_handle_t>& removed_paths,
+                          const uint64_t& nthreads = 1);
 
         /// Load this XP index from a stream. Throw an XPFormatError if the stream
         /// does not produce a valid XP file.
@@ -80,6 +159,14 @@ namespace xp {
         /// Alias for load() to match the SerializableHandleGraph interface.
         void deserialize_members(std::istream &in);
 
+        /// Map this XP index from a file. The path vectors are read in place, so
+        /// jobs using the same index share one copy in the page cache. So are the
+        /// node->path vectors through get_np_bv_view() and its siblings, but
+        /// get_np_bv(), get_nr_iv(), get_npi_iv(), serializing, add_paths() and
+        /// remove_paths() copy them into memory on first use. Indexes written
+        /// without a path record table are loaded as by load().
+        void load_mmap(const std::string &filename);
+
         /// Write this XP index to a stream.
         size_t
         serialize_and_measure(std::ostream &out, sdsl::structure_tree_node *s = nullptr, std::string name = "") const;
@@ -90,6 +177,28 @@ namespace xp {
         /// Clean the paths of the index so a new one can be generated.
         void clean();
 
+        /// Build a minimal perfect hash of the path names, so that has_path() and
+        /// get_path_handle() find exact names in constant time instead of searching
+        /// the name CSA. It is not serialized and must be rebuilt after loading.
+        void index_path_names(const uint64_t& nthreads = 1);
+
+        /// Whether index_path_names() has been run on the current paths
+        bool has_path_name_index() const;
+
+        /// Index the node->path records by node, so that for_each_step_on_handle() visits
+        /// the steps on a node in time proportional to their number. The node->path vectors
+        /// name paths by their handle in the graph the index was built from, which the given
+        /// graph resolves by path name. It is not serialized and must be rebuilt after loading.
+        void index_node_steps(const handlegraph::PathHandleGraph &graph, const uint64_t& nthreads = 1);
+
+        /// Whether index_node_steps() has been run on the current paths
+        bool has_node_step_index() const;
+
+        /// Call the iteratee on each step of the indexed paths on the node of the given handle,
+        /// as a step handle of this index. Returns false if the iteratee stopped early.
+        bool for_each_step_on_handle(const handlegraph::handle_t& handle,
+                                     const std::function<bool(const handlegraph::step_handle_t&)>& iteratee) const;
+
         /// Is this path in the index?
         bool has_path(const std::string& path_name) const;
 
@@ -126,6 +235,15 @@ namespace xp {
         /// Will exit with (1) given position is not in the given path.
         size_t get_pangenome_pos(const std::string &path_name, const size_t &nuc_pos) const;
 
+        /// Look up the pangenome positions of many 0-based (path name, nucleotide position)
+        /// queries at once. The queries are grouped by path and sorted, so that each path is
+        /// walked once from its first to its last query, and paths are resolved in parallel.
+        /// results[i] answers queries[i], and is XP_NO_PANGENOME_POS if the path or position
+        /// is not in the index.
+        void get_pangenome_positions(const std::vector<std::pair<std::string, size_t>>& queries,
+                                     std::vector<size_t>& results,
+                                     const uint64_t& nthreads = 1) const;
+
         /// Get the path of the given path name
         const XPPath& get_path(const std::string& name) const;
 
@@ -140,9 +258,15 @@ namespace xp {
 
 
         const sdsl::bit_vector::select_1_type get_np_bv_select() const;
-        const sdsl::bit_vector get_np_bv() const;
+        const sdsl::bit_vector& get_np_bv() const;
         // const sdsl::rank_support_v<1> get_np_bv_rank() const;
 
+        /// Views of np_bv, nr_iv and npi_iv that read a mapped index in place instead of
+        /// copying the vectors out of it. They stay valid until the index changes.
+        mapped_int_vector get_np_bv_view() const;
+        mapped_int_vector get_nr_iv_view() const;
+        mapped_int_vector get_npi_iv_view() const;
+
         size_t path_count = 0;
 
         char start_marker = '#';
@@ -163,16 +287,66 @@ namespace xp {
 
         sdsl::enc_vector<> pos_map_iv; // store each offset of each node in the sequence vector
 
+        // for graphs whose node ids have gaps, the handle numbers in use; nodes are indexed by their rank among them
+        sdsl::bit_vector node_present;
+        sdsl::rank_support_v<1> node_present_rank;
+        /// The rank of the node with the given handle number among the nodes of the graph
+        inline uint64_t node_rank(uint64_t number) const {
+            return node_present.empty() ? number : node_present_rank(number);
+        }
+
         std::vector<XPPath *> paths; // path structure
 
         // node->path rank
-        sdsl::int_vector<> nr_iv; // rank of step in path
+        mutable sdsl::int_vector<> nr_iv; // rank of step in path
         // path integer
-        sdsl::int_vector<> npi_iv; // path integers to directly construct path handles from
+        mutable sdsl::int_vector<> npi_iv; // path integers to directly construct path handles from
         // entity delimiter
-        sdsl::bit_vector np_bv;
+        mutable sdsl::bit_vector np_bv;
         // sdsl::bit_vector::rank_1_type np_bv_rank;
         sdsl::bit_vector::select_1_type np_bv_select;
+
+        /// Path ranks and name hashes by their slot in the path name hash
+        std::unique_ptr<boophf_path_name_t> pn_mphf;
+        std::vector<std::pair<uint64_t, uint64_t>> pn_mphf_slots;
+        /// For the node->path records, a zero per record closed by a one per node rank
+        sdsl::bit_vector ns_bv;
+        sdsl::bit_vector::select_1_type ns_bv_select;
+        /// Path ranks by the path ids the node->path vectors record
+        std::vector<uint64_t> ns_path_ranks;
+        /// The rank of the named path, or 0 if there is none
+        uint64_t get_path_rank(const std::string& path_name) const;
+        /// Set the path names from their concatenation, building the name CSA through the given file
+        void set_path_names(const std::string& path_names, const std::string& path_name_file);
+        /// The indexed paths by the integer of their path handle in the graph, which is the
+        /// path id the node->path vectors record
+        std::vector<const XPPath *> paths_by_graph_id(const handlegraph::PathHandleGraph &graph) const;
+        /// Rewrite the node->path vectors, dropping the records of the removed path ids and
+        /// adding the new [node rank, step_rank, path id, rank_of_handle_in_path] records after
+        /// each node's old ones
+        void merge_node_paths(const std::vector<const XPPath *>& path_of_id,
+                              std::vector<std::tuple<uint64_t, uint64_t, uint64_t, uint64_t>>& added,
+                              const std::vector<uint64_t>& removed);
+        /// The pangenome position of nuc_pos, which falls on the step of the given rank
+        size_t get_pangenome_pos_on_step(const XPPath& xppath, size_t step_rank, size_t nuc_pos) const;
+        /// Whether the path of the given rank has this name
+        bool path_name_equals(uint64_t rank, const std::string& path_name) const;
+
+        /// The file behind load_mmap()
+        mio::mmap_source mapped_file;
+        /// The node->path vectors of a mapped index, read in place by the views and
+        /// copied out on first use otherwise
+        const char* node_paths_begin = nullptr;
+        const char* node_paths_end = nullptr;
+        mapped_int_vector mapped_np_bv;
+        mapped_int_vector mapped_nr_iv;
+        mapped_int_vector mapped_npi_iv;
+        mutable std::atomic<bool> node_paths_pending{false};
+        mutable std::mutex node_paths_lock;
+        void load_node_paths() const;
+
+        /// Read the magic number, position map and path names
+        void load_header(std::istream &in);
     };
 
     class XPPath {
@@ -212,15 +386,35 @@ namespace xp {
 
         void load(std::istream &in);
 
+        /// Read the path from its record in a mapped file, leaving the sdsl
+        /// structures above empty
+        void map(const char* begin, const char* end);
+
         size_t serialize(std::ostream &out,
                          sdsl::structure_tree_node *v = nullptr,
                          std::string name = "") const;
 
         size_t step_rank_at_position(size_t pos) const;
 
+        /// The number of steps
+        size_t step_count() const;
+        /// The length of the path in bases
+        size_t length() const;
+        /// The offset in the path of the step with the given rank
+        size_t position(size_t rank) const;
+
         handlegraph::handle_t local_handle(const handlegraph::handle_t &handle) const;
         handlegraph::handle_t external_handle(const handlegraph::handle_t& handle) const;
         handlegraph::handle_t handle(size_t offset) const;
+
+    private:
+        bool mapped = false;
+        /// The mapped record, which serialize() copies as it is
+        const char* mapped_record = nullptr;
+        uint64_t mapped_record_size = 0;
+        mapped_int_vector mapped_handles;
+        mapped_int_vector mapped_positions;
+        uint64_t mapped_length = 0;
     };
 
     /**
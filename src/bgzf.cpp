@@ -0,0 +1,319 @@
+/**
+ * \file bgzf.cpp: gzip decompression and parallel BGZF compression
+ */
+
+#include "bgzf.hpp"
+
+#include <zlib.h>
+#include <omp.h>
+#include <cstring>
+#include <iostream>
+#include <atomic>
+#include <algorithm>
+
+namespace odgi {
+namespace bgzf {
+
+namespace {
+
+/// Size of the gzip header of a BGZF block, including the BC extra field
+const uint64_t BLOCK_HEADER_SIZE = 18;
+/// Size of the CRC32 and ISIZE trailer of a gzip member
+const uint64_t BLOCK_FOOTER_SIZE = 8;
+/// The largest a whole block may be
+const uint64_t MAX_BLOCK_SIZE = 1 << 16;
+
+/// The empty block that marks the end of a BGZF file
+const unsigned char EOF_BLOCK[28] = {
+    0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43,
+    0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+inline uint16_t read_u16(const unsigned char* p) {
+    return p[0] | (p[1] << 8);
+}
+
+inline uint32_t read_u32(const unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline void write_u16(unsigned char* p, uint16_t v) {
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+inline void write_u32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = (v >> (8 * i)) & 0xff;
+    }
+}
+
+[[noreturn]] void error(const std::string& what) {
+    std::cerr << "[odgi::bgzf] error: " << what << std::endl;
+    exit(1);
+}
+
+struct block_t {
+    /// where the compressed data starts and how long it is
+    uint64_t data_offset;
+    uint64_t data_size;
+    /// where its contents go in the output, and how much there is
+    uint64_t out_offset;
+    uint32_t out_size;
+    uint32_t crc;
+};
+
+/// Read the header of the BGZF block at the start of the data. Returns the size of
+/// the whole block, or 0 if it is not a gzip member with the BC field that gives it.
+uint64_t parse_block(const unsigned char* h, size_t size, block_t& block) {
+    if (size < BLOCK_HEADER_SIZE + BLOCK_FOOTER_SIZE
+        || h[0] != 0x1f || h[1] != 0x8b || h[2] != 8 || !(h[3] & 4)) {
+        return 0;
+    }
+    uint16_t xlen = read_u16(h + 10);
+    if (size < 12 + (uint64_t)xlen) return 0;
+    // look for the BC subfield among the extra fields
+    uint64_t block_size = 0;
+    for (uint64_t x = 0; x + 4 <= xlen; ) {
+        const unsigned char* f = h + 12 + x;
+        uint16_t slen = read_u16(f + 2);
+        if (f[0] == 'B' && f[1] == 'C' && slen == 2) {
+            block_size = (uint64_t)read_u16(f + 4) + 1;
+            break;
+        }
+        x += 4 + slen;
+    }
+    if (!block_size || block_size > size || block_size < 12 + xlen + BLOCK_FOOTER_SIZE) {
+        return 0;
+    }
+    block.data_offset = 12 + xlen;
+    block.data_size = block_size - 12 - xlen - BLOCK_FOOTER_SIZE;
+    block.crc = read_u32(h + block_size - 8);
+    block.out_size = read_u32(h + block_size - 4);
+    return block_size;
+}
+
+/// How much the serial decompressor inflates per batch
+const uint64_t SERIAL_BATCH_SIZE = 1 << 22;
+}
+
+bool is_gzip(const char* data, size_t size) {
+    return size >= 2 && (unsigned char)data[0] == 0x1f && (unsigned char)data[1] == 0x8b;
+}
+
+reader_t::reader_t(const char* data, size_t size, uint64_t n_threads)
+    : data(data), size(size), n_threads(std::max(n_threads, (uint64_t)1)) {
+}
+
+reader_t::~reader_t() {
+    rewind();
+}
+
+void reader_t::rewind() {
+    if (zs) {
+        inflateEnd(zs.get());
+        zs.reset();
+    }
+    pos = 0;
+    serial = false;
+    finished = false;
+}
+
+bool reader_t::read(std::string& out) {
+    out.clear();
+    // empty blocks, like the one that ends a BGZF file, give nothing to return
+    while (out.empty() && !finished) {
+        if (serial) {
+            read_serial(out);
+        } else {
+            read_blocks(out);
+        }
+    }
+    return !out.empty();
+}
+
+void reader_t::read_blocks(std::string& out) {
+    const uint64_t batch_blocks = n_threads * 64;
+    std::vector<block_t> blocks;
+    uint64_t out_size = 0;
+    while (blocks.size() < batch_blocks && pos < size) {
+        block_t block;
+        uint64_t block_size = parse_block((const unsigned char*)data + pos, size - pos, block);
+        if (!block_size) {
+            // what follows is read as plain gzip, which reports it if it is not
+            serial = blocks.empty();
+            break;
+        }
+        block.data_offset += pos;
+        block.out_offset = out_size;
+        out_size += block.out_size;
+        blocks.push_back(block);
+        pos += block_size;
+    }
+    if (blocks.empty()) {
+        finished = !serial;
+        return;
+    }
+    out.resize(out_size);
+    std::atomic<bool> ok(true);
+#pragma omp parallel for schedule(dynamic, 4) num_threads(n_threads)
+    for (uint64_t i = 0; i < blocks.size(); ++i) {
+        auto& block = blocks[i];
+        if (!block.out_size || !ok) continue;
+        char* block_out = &out[block.out_offset];
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        // raw deflate data, as we skip the gzip header and trailer ourselves
+        if (inflateInit2(&zs, -15) != Z_OK) {
+            ok = false;
+            continue;
+        }
+        zs.next_in = (Bytef*)(data + block.data_offset);
+        zs.avail_in = block.data_size;
+        zs.next_out = (Bytef*)block_out;
+        zs.avail_out = block.out_size;
+        int ret = inflate(&zs, Z_FINISH);
+        inflateEnd(&zs);
+        if (ret != Z_STREAM_END || zs.avail_out != 0
+            || crc32(0, (const Bytef*)block_out, block.out_size) != block.crc) {
+            ok = false;
+        }
+    }
+    if (!ok) {
+        error("corrupt BGZF block");
+    }
+}
+
+void reader_t::read_serial(std::string& out) {
+    if (!zs) {
+        zs.reset(new z_stream);
+        memset(zs.get(), 0, sizeof(z_stream));
+        // expect a gzip header
+        if (inflateInit2(zs.get(), 15 + 16) != Z_OK) {
+            error("could not initialize zlib");
+        }
+    }
+    while (out.size() < SERIAL_BATCH_SIZE) {
+        // avail_in is only 32 bits wide, and at the end of the data zlib may still hold output
+        zs->next_in = (Bytef*)(data + pos);
+        zs->avail_in = std::min((uint64_t)(size - pos), (uint64_t)1 << 30);
+        const uint64_t used = out.size();
+        out.resize(SERIAL_BATCH_SIZE);
+        zs->next_out = (Bytef*)&out[used];
+        zs->avail_out = SERIAL_BATCH_SIZE - used;
+        int ret = inflate(zs.get(), Z_NO_FLUSH);
+        out.resize(SERIAL_BATCH_SIZE - zs->avail_out);
+        pos = (const char*)zs->next_in - data;
+        if (ret == Z_BUF_ERROR && pos == size) {
+            error("truncated gzip data");
+        }
+        if (ret != Z_OK && ret != Z_STREAM_END) {
+            error("corrupt gzip data");
+        }
+        if (ret == Z_STREAM_END) {
+            if (pos == size) {
+                finished = true;
+                break;
+            }
+            // another member follows
+            inflateReset(zs.get());
+        }
+    }
+}
+
+compress_streambuf::compress_streambuf(std::ostream& out, uint64_t n_threads, int level)
+    : out(out), n_threads(std::max(n_threads, (uint64_t)1)), level(level) {
+    buffer.resize(BLOCK_DATA_SIZE * this->n_threads * 4);
+    blocks.resize(this->n_threads * 4);
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+compress_streambuf::~compress_streambuf() {
+    close();
+}
+
+void compress_streambuf::close() {
+    if (closed) return;
+    write_blocks();
+    out.write((const char*)EOF_BLOCK, sizeof(EOF_BLOCK));
+    out.flush();
+    closed = true;
+}
+
+compress_streambuf::int_type compress_streambuf::overflow(int_type c) {
+    write_blocks();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize compress_streambuf::xsputn(const char* s, std::streamsize n) {
+    std::streamsize written = 0;
+    while (written < n) {
+        std::streamsize room = epptr() - pptr();
+        if (room == 0) {
+            write_blocks();
+            continue;
+        }
+        std::streamsize take = std::min(room, n - written);
+        memcpy(pptr(), s + written, take);
+        pbump(take);
+        written += take;
+    }
+    return written;
+}
+
+int compress_streambuf::sync() {
+    // a partial block is kept until it fills, so frequent flushes do not
+    // produce many tiny blocks
+    return out.flush() ? 0 : -1;
+}
+
+void compress_streambuf::write_blocks() {
+    uint64_t used = pptr() - pbase();
+    uint64_t n_blocks = (used + BLOCK_DATA_SIZE - 1) / BLOCK_DATA_SIZE;
+    std::atomic<bool> ok(true);
+#pragma omp parallel for schedule(static, 1) num_threads(n_threads)
+    for (uint64_t i = 0; i < n_blocks; ++i) {
+        const char* input = buffer.data() + i * BLOCK_DATA_SIZE;
+        uint64_t input_size = std::min(BLOCK_DATA_SIZE, used - i * BLOCK_DATA_SIZE);
+        auto& block = blocks[i];
+        block.resize(MAX_BLOCK_SIZE);
+        unsigned char* b = (unsigned char*)&block[0];
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        if (deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            ok = false;
+            continue;
+        }
+        zs.next_in = (Bytef*)input;
+        zs.avail_in = input_size;
+        zs.next_out = b + BLOCK_HEADER_SIZE;
+        zs.avail_out = MAX_BLOCK_SIZE - BLOCK_HEADER_SIZE - BLOCK_FOOTER_SIZE;
+        int ret = deflate(&zs, Z_FINISH);
+        deflateEnd(&zs);
+        if (ret != Z_STREAM_END) {
+            // cannot happen for BLOCK_DATA_SIZE inputs, which always fit
+            ok = false;
+            continue;
+        }
+        uint64_t block_size = BLOCK_HEADER_SIZE + zs.total_out + BLOCK_FOOTER_SIZE;
+        memcpy(b, EOF_BLOCK, BLOCK_HEADER_SIZE);
+        write_u16(b + 16, block_size - 1);
+        write_u32(b + block_size - 8, crc32(0, (const Bytef*)input, input_size));
+        write_u32(b + block_size - 4, input_size);
+        block.resize(block_size);
+    }
+    if (!ok) {
+        error("could not compress a block");
+    }
+    for (uint64_t i = 0; i < n_blocks; ++i) {
+        out.write(blocks[i].data(), blocks[i].size());
+    }
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+}
+}
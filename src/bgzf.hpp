@@ -0,0 +1,101 @@
+#pragma once
+
+/**
+ * \file bgzf.hpp
+ *
+ * Reading gzip data and writing it in the blocked gzip format (BGZF) used by
+ * bgzip and htslib. BGZF is a series of independent gzip members of at most
+ * 64 KiB, so both directions can work on many blocks at once.
+ *
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <streambuf>
+#include <memory>
+
+struct z_stream_s;
+
+namespace odgi {
+namespace bgzf {
+
+/// The most uncompressed data we put in one block, as bgzip does
+const uint64_t BLOCK_DATA_SIZE = 0xff00;
+
+/// Whether the buffer starts with the gzip magic number
+bool is_gzip(const char* data, size_t size);
+
+/// Reads gzip data from a buffer one batch of a few MiB at a time, so that
+/// the whole of the decompressed data is never held. BGZF blocks are inflated
+/// n_threads at a time; once a member without the BGZF block size is met, the
+/// rest, which may be many concatenated members, is inflated on one thread.
+class reader_t {
+public:
+    /// Read the gzip data in the buffer, which must outlive the reader
+    reader_t(const char* data, size_t size, uint64_t n_threads = 1);
+    ~reader_t();
+    reader_t(const reader_t& other) = delete;
+    reader_t& operator=(const reader_t& other) = delete;
+    /// Replace out with the next batch of decompressed data. Returns false, with
+    /// out empty, once everything has been read. Exits with an error on corrupt input.
+    bool read(std::string& out);
+    /// Start reading from the beginning again
+    void rewind(void);
+private:
+    /// Inflate the next batch of BGZF blocks, or switch to serial reading if there are none
+    void read_blocks(std::string& out);
+    /// Inflate up to a batch of data with the serial decompressor
+    void read_serial(std::string& out);
+    const char* data;
+    size_t size;
+    uint64_t n_threads;
+    /// where the next compressed data to read starts
+    uint64_t pos = 0;
+    bool serial = false;
+    bool finished = false;
+    std::unique_ptr<z_stream_s> zs;
+};
+
+/// A stream buffer that collects output into BGZF blocks and compresses a
+/// batch of them at a time on several threads, writing them in order.
+/// Flushing does not cut a block short; everything is written by close().
+class compress_streambuf : public std::streambuf {
+public:
+    compress_streambuf(std::ostream& out, uint64_t n_threads = 1, int level = 6);
+    ~compress_streambuf();
+    /// Write any buffered data and the BGZF end-of-file marker
+    void close(void);
+protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+    int sync(void) override;
+private:
+    /// Compress and write everything that is buffered
+    void write_blocks(void);
+    std::ostream& out;
+    uint64_t n_threads;
+    int level;
+    bool closed = false;
+    std::vector<char> buffer;
+    std::vector<std::string> blocks;
+};
+
+/// An output stream that writes BGZF to another stream
+class ostream : public std::ostream {
+public:
+    ostream(std::ostream& out, uint64_t n_threads = 1, int level = 6)
+        : std::ostream(nullptr), buf(out, n_threads, level) {
+        rdbuf(&buf);
+    }
+    /// Finish the compressed stream; also done on destruction
+    void close(void) {
+        buf.close();
+    }
+private:
+    compress_streambuf buf;
+};
+
+}
+}
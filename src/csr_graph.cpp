@@ -0,0 +1,140 @@
+/**
+ * \file csr_graph.cpp: contains the implementation of CSRHandleGraph
+ */
+
+#include "csr_graph.hpp"
+
+#include <omp.h>
+
+namespace odgi {
+
+CSRHandleGraph::CSRHandleGraph(const graph_t* super, uint64_t num_threads) : super(super) {
+    id_base = super->get_id(number_bool_packing::pack(0, false));
+    // deleted nodes leave holes in the rank space, which we keep so that
+    // our handles stay those of the source graph
+    super->for_each_handle([&](const handle_t& h) {
+        uint64_t rank = number_bool_packing::unpack_number(h);
+        if (rank >= present.size()) {
+            present.resize(rank + 1, false);
+        }
+        present[rank] = true;
+        nid_t id = super->get_id(h);
+        min_id = std::min(id, min_id);
+        max_id = std::max(id, max_id);
+        ++node_count;
+    });
+    const uint64_t rank_count = present.size();
+    lengths.resize(rank_count, 0);
+    offsets.resize(2 * rank_count + 1, 0);
+    // count the right-side neighbours of each oriented handle
+#pragma omp parallel for schedule(dynamic, 1024) num_threads(num_threads)
+    for (uint64_t i = 0; i < rank_count; ++i) {
+        if (!present[i]) continue;
+        for (auto is_rev : { false, true }) {
+            handle_t h = number_bool_packing::pack(i, is_rev);
+            uint64_t degree = 0;
+            super->follow_edges(h, false, [&](const handle_t& next) {
+                ++degree;
+            });
+            offsets[as_integer(h) + 1] = degree;
+        }
+        lengths[i] = super->get_length(number_bool_packing::pack(i, false));
+    }
+    for (uint64_t i = 1; i < offsets.size(); ++i) {
+        offsets[i] += offsets[i - 1];
+    }
+    neighbors.resize(offsets.back());
+    // each handle writes only into its own range
+#pragma omp parallel for schedule(dynamic, 1024) num_threads(num_threads)
+    for (uint64_t i = 0; i < rank_count; ++i) {
+        if (!present[i]) continue;
+        for (auto is_rev : { false, true }) {
+            handle_t h = number_bool_packing::pack(i, is_rev);
+            uint64_t j = offsets[as_integer(h)];
+            super->follow_edges(h, false, [&](const handle_t& next) {
+                neighbors[j++] = next;
+            });
+        }
+    }
+}
+
+bool CSRHandleGraph::has_node(nid_t node_id) const {
+    if (node_id < id_base) return false;
+    uint64_t rank = node_id - id_base;
+    return rank < present.size() && present[rank];
+}
+
+handle_t CSRHandleGraph::get_handle(const nid_t& node_id, bool is_reverse) const {
+    return number_bool_packing::pack(node_id - id_base, is_reverse);
+}
+
+nid_t CSRHandleGraph::get_id(const handle_t& handle) const {
+    return number_bool_packing::unpack_number(handle) + id_base;
+}
+
+bool CSRHandleGraph::get_is_reverse(const handle_t& handle) const {
+    return number_bool_packing::unpack_bit(handle);
+}
+
+handle_t CSRHandleGraph::flip(const handle_t& handle) const {
+    return number_bool_packing::toggle_bit(handle);
+}
+
+size_t CSRHandleGraph::get_length(const handle_t& handle) const {
+    return lengths[number_bool_packing::unpack_number(handle)];
+}
+
+std::string CSRHandleGraph::get_sequence(const handle_t& handle) const {
+    return super->get_sequence(handle);
+}
+
+bool CSRHandleGraph::follow_edges_impl(const handle_t& handle, bool go_left,
+                                       const std::function<bool(const handle_t&)>& iteratee) const {
+    // the left side of a handle is the right side of its reverse, seen from the other strand
+    uint64_t side = as_integer(go_left ? flip(handle) : handle);
+    for (uint64_t i = offsets[side]; i < offsets[side + 1]; ++i) {
+        if (!iteratee(go_left ? flip(neighbors[i]) : neighbors[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CSRHandleGraph::for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    if (parallel) {
+        volatile bool flag = true;
+#pragma omp parallel for
+        for (uint64_t i = 0; i < present.size(); ++i) {
+            if (!present[i] || !flag) continue;
+            bool result = iteratee(number_bool_packing::pack(i, false));
+#pragma omp atomic
+            flag &= result;
+        }
+        return flag;
+    } else {
+        for (uint64_t i = 0; i < present.size(); ++i) {
+            if (!present[i]) continue;
+            if (!iteratee(number_bool_packing::pack(i, false))) return false;
+        }
+        return true;
+    }
+}
+
+size_t CSRHandleGraph::get_node_count() const {
+    return node_count;
+}
+
+nid_t CSRHandleGraph::min_node_id() const {
+    return min_id;
+}
+
+nid_t CSRHandleGraph::max_node_id() const {
+    return max_id;
+}
+
+size_t CSRHandleGraph::get_degree(const handle_t& handle, bool go_left) const {
+    uint64_t side = as_integer(go_left ? flip(handle) : handle);
+    return offsets[side + 1] - offsets[side];
+}
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+/** \file
+ * csr_graph.hpp: defines a read-only compressed sparse row snapshot of the
+ * adjacency of a graph_t
+ */
+
+#include "odgi.hpp"
+#include <handlegraph/handle_graph.hpp>
+#include <handlegraph/util.hpp>
+#include <vector>
+#include <string>
+#include <limits>
+
+namespace odgi {
+
+using namespace handlegraph;
+
+    /**
+     * A HandleGraph implementation that copies the edges of a graph_t into
+     * flat arrays: for every oriented handle, an offset into a single vector
+     * of packed neighbour handles on its right side. Left-side neighbours are
+     * read from the reverse orientation, so each edge is stored once per side.
+     * Neighbour scans are then contiguous reads rather than a decode of the
+     * node's edge records. Handles are those of the source graph, so they can
+     * be passed back to it for sequence, path and step queries. The snapshot
+     * is invalidated by any topological change to the source graph.
+     */
+    class CSRHandleGraph : public HandleGraph {
+    public:
+
+        /// Build the snapshot from a graph, decoding its nodes in parallel
+        CSRHandleGraph(const graph_t* super, uint64_t num_threads = 1);
+
+        //////////////////////////
+        /// HandleGraph interface
+        //////////////////////////
+
+        // Method to check if a node exists by ID
+        virtual bool has_node(nid_t node_id) const;
+
+        /// Look up the handle for the node with the given ID in the given orientation
+        virtual handle_t get_handle(const nid_t& node_id, bool is_reverse = false) const;
+
+        /// Get the ID from a handle
+        virtual nid_t get_id(const handle_t& handle) const;
+
+        /// Get the orientation of a handle
+        virtual bool get_is_reverse(const handle_t& handle) const;
+
+        /// Invert the orientation of a handle (potentially without getting its ID)
+        virtual handle_t flip(const handle_t& handle) const;
+
+        /// Get the length of a node
+        virtual size_t get_length(const handle_t& handle) const;
+
+        /// Get the sequence of a node, presented in the handle's local forward
+        /// orientation.
+        virtual std::string get_sequence(const handle_t& handle) const;
+
+        /// Loop over all the handles to next/previous (right/left) nodes. Passes
+        /// them to a callback which returns false to stop iterating and true to
+        /// continue. Returns true if we finished and false if we stopped early.
+        virtual bool follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const;
+
+        /// Loop over all the nodes in the graph in their local forward
+        /// orientations, in their internal stored order. Stop if the iteratee
+        /// returns false. Can be told to run in parallel, in which case stopping
+        /// after a false return value is on a best-effort basis and iteration
+        /// order is not defined.
+        virtual bool for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel = false) const;
+
+        /// Return the number of nodes in the graph
+        virtual size_t get_node_count() const;
+
+        /// Return the smallest ID in the graph, or some smaller number if the
+        /// smallest ID is unavailable. Return value is unspecified if the graph is empty.
+        virtual nid_t min_node_id() const;
+
+        /// Return the largest ID in the graph, or some larger number if the
+        /// largest ID is unavailable. Return value is unspecified if the graph is empty.
+        virtual nid_t max_node_id() const;
+
+        /// Get the number of edges on the right (go_left = false) or left (go_left
+        /// = true) side of the given handle, in constant time.
+        virtual size_t get_degree(const handle_t& handle, bool go_left) const;
+
+    private:
+        const graph_t* super = nullptr;
+        /// id of the node at rank 0
+        nid_t id_base = 1;
+        uint64_t node_count = 0;
+        nid_t min_id = std::numeric_limits<nid_t>::max();
+        nid_t max_id = std::numeric_limits<nid_t>::min();
+        /// whether each rank holds a live node
+        std::vector<bool> present;
+        /// node lengths by rank
+        std::vector<uint64_t> lengths;
+        /// for each oriented handle (as_integer(handle)), the start of its
+        /// right-side neighbours in neighbors; one extra entry closes the last range
+        std::vector<uint64_t> offsets;
+        std::vector<handle_t> neighbors;
+    };
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+/**
+ * \file dense_table.hpp
+ *
+ * A table indexed by small dense integers that grows without moving its
+ * entries. Storage is a series of blocks that double in size, so an index
+ * finds its block with one bit scan, references stay valid as the table
+ * grows, and readers need no locks while another thread extends it.
+ *
+ */
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+
+namespace odgi {
+
+template<typename T, uint64_t FIRST_BLOCK_BITS = 8>
+class dense_table_t {
+public:
+    dense_table_t(void) {
+        for (auto& block : blocks) {
+            block.store(nullptr);
+        }
+    }
+    ~dense_table_t(void) {
+        clear();
+    }
+    dense_table_t(const dense_table_t& other) = delete;
+    dense_table_t& operator=(const dense_table_t& other) = delete;
+
+    /// The entry at index i, which must be below a size passed to reserve()
+    inline T& operator[](uint64_t i) const {
+        uint64_t b = block_of(i);
+        return blocks[b].load(std::memory_order_acquire)[i + FIRST_BLOCK_SIZE - block_start(b)];
+    }
+
+    /// Whether index i has storage
+    inline bool contains(uint64_t i) const {
+        return blocks[block_of(i)].load(std::memory_order_acquire) != nullptr;
+    }
+
+    /// Make sure that every index below size has storage. Entries are value
+    /// initialized. Safe to call while other threads read or reserve.
+    void reserve(uint64_t size) {
+        if (size == 0) return;
+        uint64_t last = block_of(size - 1);
+        // blocks are always allocated in order, so the last one tells all
+        if (blocks[last].load(std::memory_order_acquire) != nullptr) return;
+        std::lock_guard<std::mutex> guard(growth);
+        for (uint64_t b = 0; b <= last; ++b) {
+            if (blocks[b].load(std::memory_order_relaxed) == nullptr) {
+                blocks[b].store(new T[block_start(b)](), std::memory_order_release);
+            }
+        }
+    }
+
+    /// Drop all entries. Not safe while other threads use the table.
+    void clear(void) {
+        for (auto& block : blocks) {
+            delete[] block.load();
+            block.store(nullptr);
+        }
+    }
+
+private:
+    static const uint64_t FIRST_BLOCK_SIZE = (uint64_t)1 << FIRST_BLOCK_BITS;
+    static const uint64_t BLOCK_COUNT = 64 - FIRST_BLOCK_BITS;
+    /// Block b holds the FIRST_BLOCK_SIZE << b indexes from block_start(b) - FIRST_BLOCK_SIZE
+    static inline uint64_t block_of(uint64_t i) {
+        return 63 - __builtin_clzll(i + FIRST_BLOCK_SIZE) - FIRST_BLOCK_BITS;
+    }
+    static inline uint64_t block_start(uint64_t b) {
+        return FIRST_BLOCK_SIZE << b;
+    }
+    std::atomic<T*> blocks[BLOCK_COUNT];
+    std::mutex growth;
+};
+
+}
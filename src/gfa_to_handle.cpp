@@ -1,153 +1,420 @@
 #include "gfa_to_handle.hpp"
+#include "bgzf.hpp"
+
+#include <cstring>
+#include <numeric>
 
 namespace odgi {
 
-std::map<char, uint64_t> gfa_line_counts(const char* filename) {
-    int gfa_fd = -1;
-    char* gfa_buf = nullptr;
-    size_t gfa_filesize = gfak::mmap_open(filename, gfa_buf, gfa_fd);
-    if (gfa_fd == -1) {
-        cerr << "Couldn't open GFA file " << filename << "." << endl;
-        exit(1);
+namespace {
+
+/// A range of whole lines in a window of the file
+struct gfa_chunk_t {
+    const char* begin;
+    const char* end;
+};
+
+/// What the counting pass learns about one chunk
+struct gfa_chunk_summary_t {
+    uint64_t node_count = 0;
+    uint64_t edge_count = 0;
+    uint64_t min_id = std::numeric_limits<uint64_t>::max();
+    uint64_t max_id = 0;
+    /// offsets of the P lines from the start of their window, in file order
+    std::vector<uint64_t> paths;
+    /// bytes in the P lines
+    uint64_t path_bytes = 0;
+};
+
+/// Split the buffer into about n_chunks ranges that each start at the beginning of a line
+std::vector<gfa_chunk_t> gfa_line_chunks(const char* buf, size_t size, uint64_t n_chunks) {
+    const size_t min_chunk_size = 1 << 20;
+    size_t chunk_size = std::max(min_chunk_size, size / std::max(n_chunks, (uint64_t)1) + 1);
+    std::vector<gfa_chunk_t> chunks;
+    const char* end = buf + size;
+    const char* p = buf;
+    while (p < end) {
+        const char* q = p + std::min(chunk_size, (size_t)(end - p));
+        if (q < end) {
+            const char* nl = (const char*)memchr(q, '\n', end - q);
+            q = nl ? nl + 1 : end;
+        }
+        chunks.push_back({p, q});
+        p = q;
+    }
+    return chunks;
+}
+
+/// The end of the line starting at p, not including the newline or a carriage return before it
+inline const char* gfa_line_end(const char* p, const char* end) {
+    const char* nl = (const char*)memchr(p, '\n', end - p);
+    const char* e = nl ? nl : end;
+    if (e > p && *(e-1) == '\r') --e;
+    return e;
+}
+
+/// The start of the line following the one that starts at p
+inline const char* gfa_next_line(const char* p, const char* end) {
+    const char* nl = (const char*)memchr(p, '\n', end - p);
+    return nl ? nl + 1 : end;
+}
+
+/// The start of the field after the one at p, or line_end if it is the last
+inline const char* gfa_next_field(const char* p, const char* line_end) {
+    const char* tab = (const char*)memchr(p, '\t', line_end - p);
+    return tab ? tab + 1 : line_end;
+}
+
+/// Read a decimal node id at p and advance past it
+inline bool gfa_parse_id(const char*& p, const char* line_end, uint64_t& id) {
+    const char* start = p;
+    id = 0;
+    while (p < line_end && *p >= '0' && *p <= '9') {
+        id = id * 10 + (*p - '0');
+        ++p;
     }
-    string line;
-    size_t i = 0;
-    bool seen_newline = true;
-    std::map<char, uint64_t> counts;
-    while (i < gfa_filesize) {
-        if (i == 0 || gfa_buf[i-1] == '\n') {
-            counts[gfa_buf[i]]++;
+    return p != start;
+}
+
+[[noreturn]] void gfa_record_error(const char* line, const char* line_end, const std::string& what) {
+    std::cerr << "[odgi::gfa_to_handle] error: " << what << " in GFA record: "
+              << std::string(line, std::min(line_end, line + 256)) << std::endl;
+    exit(1);
+}
+
+/// Read the node id field of an S line
+inline uint64_t gfa_segment_id(const char* line, const char* line_end) {
+    const char* p = line + 2;
+    uint64_t id;
+    if (line_end - line < 3 || line[1] != '\t'
+        || !gfa_parse_id(p, line_end, id) || (p != line_end && *p != '\t') || id == 0) {
+        gfa_record_error(line, line_end, "segment names must be positive integers");
+    }
+    return id;
+}
+
+/// Read one end of an L line: an id field and an orientation field
+inline void gfa_link_end(const char*& p, const char* line, const char* line_end, uint64_t& id, bool& is_rev) {
+    if (!gfa_parse_id(p, line_end, id) || p == line_end || *p != '\t'
+        || p + 2 > line_end || (p[1] != '+' && p[1] != '-')) {
+        gfa_record_error(line, line_end, "malformed link");
+    }
+    is_rev = (p[1] == '-');
+    p = gfa_next_field(p + 2, line_end);
+}
+
+/// The GFA text, handed out in windows of whole lines. A plain file is mapped and is a
+/// single window. Compressed input is inflated a batch at a time into a window that
+/// holds the batch and the end of a line left from the one before, so it is never
+/// stored whole; a window only grows past a batch to fit a longer line. Each pass
+/// inflates it again, and cuts it into the same windows.
+class gfa_input_t {
+public:
+    gfa_input_t(const std::string& filename, uint64_t n_threads) {
+        filesize = gfak::mmap_open(filename.c_str(), buf, fd);
+        if (fd == -1) {
+            std::cerr << "[odgi::gfa_to_handle] error: couldn't open GFA file " << filename << "." << std::endl;
+            exit(1);
+        }
+        if (bgzf::is_gzip(buf, filesize)) {
+            reader = std::make_unique<bgzf::reader_t>(buf, filesize, n_threads);
         }
-        ++i;
     }
-    gfak::mmap_close(gfa_buf, gfa_fd, gfa_filesize);
-    return counts;
+
+    ~gfa_input_t() {
+        reader.reset();
+        gfak::mmap_close(buf, fd, filesize);
+    }
+
+    /// Call the function on each window in file order
+    void for_each_window(const std::function<void(const char*, const char*)>& fn) {
+        if (!reader) {
+            if (filesize) fn(buf, buf + filesize);
+            return;
+        }
+        reader->rewind();
+        std::string window;
+        std::string batch;
+        bool more = true;
+        while (more) {
+            more = reader->read(batch);
+            // the end of the last complete line, which can only be in the new batch
+            size_t cut = window.size() + batch.size();
+            window.append(batch);
+            if (more) {
+                const size_t batch_begin = window.size() - batch.size();
+                while (cut > batch_begin && window[cut - 1] != '\n') --cut;
+                if (cut == batch_begin) {
+                    // no line ends in this batch
+                    continue;
+                }
+            }
+            if (cut) fn(window.data(), window.data() + cut);
+            window.erase(0, cut);
+        }
+    }
+
+private:
+    char* buf = nullptr;
+    int fd = -1;
+    size_t filesize = 0;
+    std::unique_ptr<bgzf::reader_t> reader;
+};
+
 }
 
 void gfa_to_handle(const string& gfa_filename,
-                   handlegraph::MutablePathMutableHandleGraph* graph,
+                   graph_t* graph,
                    uint64_t n_threads,
                    bool progress) {
 
     n_threads = (n_threads == 0 ? 1 : n_threads);
-    char* filename = (char*) gfa_filename.c_str();
-    //std::cerr << "filename is " << filename << std::endl;
-    gfak::GFAKluge gg;
-    uint64_t i = 0;
+    gfa_input_t input(gfa_filename, n_threads);
+    // several chunks per thread keep the threads busy when record types cluster in the file
+    const uint64_t chunks_per_window = n_threads * 8;
+
+    // count the records and find the id range; the chunks of each window
+    // are the same in every pass, so their counts can be used in the next
+    std::vector<gfa_chunk_summary_t> summaries;
+    input.for_each_window([&](const char* window, const char* window_end) {
+        std::vector<gfa_chunk_t> chunks = gfa_line_chunks(window, window_end - window, chunks_per_window);
+        const uint64_t first = summaries.size();
+        summaries.resize(first + chunks.size());
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+        for (uint64_t c = 0; c < chunks.size(); ++c) {
+            auto& summary = summaries[first + c];
+            const char* end = chunks[c].end;
+            for (const char* line = chunks[c].begin; line < end; line = gfa_next_line(line, end)) {
+                switch (*line) {
+                case 'S': {
+                    uint64_t id = gfa_segment_id(line, gfa_line_end(line, end));
+                    summary.min_id = std::min(summary.min_id, id);
+                    summary.max_id = std::max(summary.max_id, id);
+                    ++summary.node_count;
+                    break;
+                }
+                case 'L':
+                    ++summary.edge_count;
+                    break;
+                case 'P':
+                    summary.paths.push_back(line - window);
+                    summary.path_bytes += gfa_line_end(line, end) - line;
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+    });
     uint64_t min_id = std::numeric_limits<uint64_t>::max();
-    uint64_t max_id = std::numeric_limits<uint64_t>::min();
-    std::map<char, uint64_t> line_counts;
-    // in parallel scan over the file to count edges and sequences
-    {
-        std::thread x(
-            [&](void) {
-                gg.for_each_sequence_line_in_file(
-                    filename,
-                    [&](gfak::sequence_elem s) {
-                        uint64_t id = stol(s.name);
-                        min_id = std::min(min_id, id);
-                        max_id = std::max(max_id, id);
-                    });
-            });
-        line_counts = gfa_line_counts(filename);
-        x.join();
+    uint64_t max_id = 0;
+    uint64_t node_count = 0;
+    uint64_t edge_count = 0;
+    uint64_t path_count = 0;
+    for (auto& summary : summaries) {
+        min_id = std::min(min_id, summary.min_id);
+        max_id = std::max(max_id, summary.max_id);
+        node_count += summary.node_count;
+        edge_count += summary.edge_count;
+        path_count += summary.paths.size();
     }
-    uint64_t id_increment = min_id - 1;
-    uint64_t node_count = line_counts['S'];
-    uint64_t edge_count = line_counts['L'];
-    uint64_t path_count = line_counts['P'];
+    uint64_t id_increment = node_count ? min_id - 1 : 0;
     // set the min id as an offset
     graph->set_id_increment(id_increment);
-    // build the nodes
+    graph->prepare_bulk_nodes(node_count ? max_id - id_increment : 0);
+
+    // build the nodes, and collect the edges until every node they refer to exists;
+    // each chunk writes its links at its own offset so that file order is kept
+    std::vector<uint64_t> edge_offsets(summaries.size() + 1, 0);
+    for (uint64_t c = 0; c < summaries.size(); ++c) {
+        edge_offsets[c + 1] = edge_offsets[c] + summaries[c].edge_count;
+    }
+    std::vector<edge_t> edges(edge_count);
+    // a bit per id, as the id range is only known once the records are counted;
+    // a segment named twice is caught before its node is built a second time
+    atomicbitvector::atomic_bv_t seen_ids(node_count ? max_id - id_increment + 1 : 0);
     {
         std::unique_ptr<algorithms::progress_meter::ProgressMeter> progress_meter;
         if (progress) {
             progress_meter = std::make_unique<algorithms::progress_meter::ProgressMeter>(
                 node_count, "[odgi::gfa_to_handle] building nodes:");
         }
-        gg.for_each_sequence_line_in_file(
-            filename,
-            [&](gfak::sequence_elem s) {
-                uint64_t id = stol(s.name);
-                graph->create_handle(s.sequence, id - id_increment);
-                if (progress) progress_meter->increment(1);
-            });
+        uint64_t first = 0;
+        input.for_each_window([&](const char* window, const char* window_end) {
+            std::vector<gfa_chunk_t> chunks = gfa_line_chunks(window, window_end - window, chunks_per_window);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+            for (uint64_t c = 0; c < chunks.size(); ++c) {
+                uint64_t e = edge_offsets[first + c];
+                const char* end = chunks[c].end;
+                for (const char* line = chunks[c].begin; line < end; line = gfa_next_line(line, end)) {
+                    if (*line == 'S') {
+                        const char* line_end = gfa_line_end(line, end);
+                        uint64_t id = gfa_segment_id(line, line_end);
+                        const char* seq = gfa_next_field(line + 2, line_end);
+                        const char* seq_end = (const char*)memchr(seq, '\t', line_end - seq);
+                        if (!seq_end) seq_end = line_end;
+                        if (seq == seq_end) {
+                            gfa_record_error(line, line_end, "missing segment sequence");
+                        }
+                        if (seen_ids.set(id - id_increment)) {
+                            gfa_record_error(line, line_end, "duplicate segment name");
+                        }
+                        graph->create_bulk_handle(std::string(seq, seq_end), id - id_increment);
+                    } else if (*line == 'L') {
+                        const char* line_end = gfa_line_end(line, end);
+                        if (line_end - line < 2 || line[1] != '\t') {
+                            gfa_record_error(line, line_end, "malformed link");
+                        }
+                        const char* p = line + 2;
+                        uint64_t from, to;
+                        bool from_rev, to_rev;
+                        gfa_link_end(p, line, line_end, from, from_rev);
+                        gfa_link_end(p, line, line_end, to, to_rev);
+                        edges[e++] = std::make_pair(graph->get_handle(from, from_rev),
+                                                    graph->get_handle(to, to_rev));
+                    }
+                }
+                if (progress) progress_meter->increment(summaries[first + c].node_count);
+            }
+            first += chunks.size();
+        });
+        graph->finish_bulk_nodes();
         if (progress) {
             progress_meter->finish();
         }
     }
-    
+
     {
         std::unique_ptr<algorithms::progress_meter::ProgressMeter> progress_meter;
         if (progress) {
             progress_meter = std::make_unique<algorithms::progress_meter::ProgressMeter>(
                 edge_count, "[odgi::gfa_to_handle] building edges:");
         }
-        gg.for_each_edge_line_in_file(
-            filename,
-            [&](gfak::edge_elem e) {
-                if (e.source_name.empty()) return;
-                handlegraph::handle_t a = graph->get_handle(stol(e.source_name), !e.source_orientation_forward);
-                handlegraph::handle_t b = graph->get_handle(stol(e.sink_name), !e.sink_orientation_forward);
-                graph->create_edge(a, b);
-                if (progress) progress_meter->increment(1);
-            });
+        graph->set_number_of_threads(n_threads);
+        graph->create_edges(edges);
+        std::vector<edge_t>().swap(edges);
         if (progress) {
+            progress_meter->increment(edge_count);
             progress_meter->finish();
         }
     }
 
     if (path_count > 0) {
+        // path records are split into pieces of about this many bytes, so
+        // that one very long path is spread over all the workers
+        const uint64_t segment_bytes = 1 << 20;
+        uint64_t path_bytes = 0;
+        for (auto& summary : summaries) {
+            path_bytes += summary.path_bytes;
+        }
         std::unique_ptr<algorithms::progress_meter::ProgressMeter> progress_meter;
         if (progress) {
             progress_meter = std::make_unique<algorithms::progress_meter::ProgressMeter>(
-                path_count, "[odgi::gfa_to_handle] building paths:");
+                path_bytes, "[odgi::gfa_to_handle] building paths:");
         }
-        gfa_path_queue_t path_queue;
-        std::mutex logging_mutex;
-        std::atomic<bool> work_todo;
-        uint64_t idx = 0;
+        // per path, filled in by the workers and attached in order at the end
+        std::deque<gfa_path_build_t> builds;
         auto worker =
-            [&](uint64_t tid) {
-                while (work_todo.load()) {
-                    path_elem_t * p;
-                    if (path_queue.try_pop(p)) {
-                        uint64_t i = 0;
-                        for (auto& s : p->gfak.segment_names) {
-                            graph->append_step(p->path,
-                                               graph->get_handle(std::stoi(s),
-                                                                 // in gfak, true == +
-                                                                 !p->gfak.orientations[i++]));
+            [&](gfa_path_queue_t& path_queue) {
+                std::vector<handle_t> handles;
+                gfa_path_segment_t segment;
+                while (path_queue.pop(segment)) {
+                    // parse the whole segment before touching the graph
+                    handles.clear();
+                    const char* s = segment.begin;
+                    while (s < segment.end) {
+                        uint64_t id;
+                        if (!gfa_parse_id(s, segment.end, id)
+                            || s == segment.end || (*s != '+' && *s != '-')) {
+                            gfa_record_error(segment.begin, segment.end, "malformed path step");
                         }
-                        delete p;
-                        if (progress) progress_meter->increment(1);
-                    } else {
-                        std::this_thread::sleep_for(std::chrono::nanoseconds(1));
+                        handles.push_back(graph->get_handle(id, *s == '-'));
+                        if (++s < segment.end && *s++ != ',') {
+                            gfa_record_error(segment.begin, segment.end, "malformed path step");
+                        }
+                    }
+                    auto& build = *segment.build;
+                    if (!handles.empty()) {
+                        build.segments[segment.rank] = graph->create_path_segment(build.path, handles);
                     }
+                    build.lengths[segment.rank] = handles.size();
+                    if (progress) progress_meter->increment(segment.end - segment.begin);
                 }
             };
 
-        std::vector<std::thread> workers;
-        workers.reserve(n_threads);
-        work_todo.store(true);
-        for (uint64_t t = 0; t < n_threads; ++t) {
-            workers.emplace_back(worker, t);
-        }
+        uint64_t first = 0;
+        input.for_each_window([&](const char* window, const char* window_end) {
+            const uint64_t chunk_count = gfa_line_chunks(window, window_end - window, chunks_per_window).size();
+            const uint64_t window_path_count = std::accumulate(
+                summaries.begin() + first, summaries.begin() + first + chunk_count, (uint64_t)0,
+                [](uint64_t sum, const gfa_chunk_summary_t& summary) { return sum + summary.paths.size(); });
+            if (window_path_count == 0) {
+                first += chunk_count;
+                return;
+            }
+            // the reader stays at most a few segments ahead of the workers, which
+            // are done with the window once the queue is drained
+            gfa_path_queue_t path_queue(4 * n_threads);
+            std::vector<std::thread> workers;
+            workers.reserve(n_threads);
+            for (uint64_t t = 0; t < n_threads; ++t) {
+                workers.emplace_back(worker, std::ref(path_queue));
+            }
 
-        gg.for_each_path_line_in_file(
-            filename,
-            [&](const gfak::path_elem& path) {
-                handlegraph::path_handle_t p_h = graph->create_path_handle(path.name);
-                path_elem_t* p = new path_elem_t({p_h, path});
-                path_queue.push(p);
-            });
+            // path handles are created in file order so that they are stable across builds
+            for (uint64_t c = first; c < first + chunk_count; ++c) {
+                for (auto& offset : summaries[c].paths) {
+                    const char* line = window + offset;
+                    const char* line_end = gfa_line_end(line, window_end);
+                    const char* name = gfa_next_field(line, line_end);
+                    const char* steps = gfa_next_field(name, line_end);
+                    const char* name_end = steps > name && steps < line_end ? steps - 1 : line_end;
+                    if (name == name_end) {
+                        gfa_record_error(line, line_end, "missing path name");
+                    }
+                    const char* steps_end = (const char*)memchr(steps, '\t', line_end - steps);
+                    if (!steps_end) steps_end = line_end;
+                    builds.emplace_back();
+                    auto& build = builds.back();
+                    build.path = graph->create_path_handle(std::string(name, name_end));
+                    if (steps_end - steps == 1 && *steps == '*') {
+                        continue;
+                    }
+                    // cut the steps field after the first comma past each segment_bytes
+                    std::vector<const char*> cuts = { steps };
+                    while (steps_end - cuts.back() > segment_bytes) {
+                        const char* comma = (const char*)memchr(cuts.back() + segment_bytes, ',',
+                                                                steps_end - (cuts.back() + segment_bytes));
+                        if (!comma) break;
+                        cuts.push_back(comma + 1);
+                    }
+                    cuts.push_back(steps_end);
+                    uint64_t segment_count = cuts.size() - 1;
+                    build.segments.resize(segment_count);
+                    build.lengths.resize(segment_count, 0);
+                    for (uint64_t i = 0; i < segment_count; ++i) {
+                        // drop the comma that ends all but the last segment
+                        const char* end = (i + 1 < segment_count ? cuts[i + 1] - 1 : cuts[i + 1]);
+                        path_queue.push({&build, i, cuts[i], end});
+                    }
+                }
+            }
+            path_queue.close();
+            for (uint64_t t = 0; t < n_threads; ++t) {
+                workers[t].join();
+            }
+            first += chunk_count;
+        });
 
-        while (!path_queue.was_empty()) {
-            std::this_thread::sleep_for(std::chrono::nanoseconds(1));
-        }
-        work_todo.store(false);
-        for (uint64_t t = 0; t < n_threads; ++t) {
-            workers[t].join();
+        // link the segments of each path together
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+        for (uint64_t i = 0; i < builds.size(); ++i) {
+            auto& build = builds[i];
+            for (uint64_t j = 0; j < build.segments.size(); ++j) {
+                if (build.lengths[j]) {
+                    graph->append_path_segment(build.path, build.segments[j], build.lengths[j]);
+                }
+            }
         }
         if (progress) {
             progress_meter->finish();
@@ -15,24 +15,82 @@
 #include <thread>
 #include <mutex>
 #include <functional>
-#include "atomic_queue.h"
+#include <deque>
+#include <condition_variable>
 #include "progress.hpp"
+#include "odgi.hpp"
 
 namespace odgi {
 
-struct path_elem_t {
+/// The steps of one path as they are built, one entry per segment of its P line
+struct gfa_path_build_t {
     handlegraph::path_handle_t path;
-    gfak::path_elem gfak;
+    std::vector<std::pair<handlegraph::step_handle_t, handlegraph::step_handle_t>> segments;
+    std::vector<uint64_t> lengths;
 };
 
-typedef atomic_queue::AtomicQueue<path_elem_t*, 2 << 10> gfa_path_queue_t;
+/// A piece of the steps field of a P line, handed to a worker to parse and build
+struct gfa_path_segment_t {
+    gfa_path_build_t* build;
+    uint64_t rank;
+    const char* begin;
+    const char* end;
+};
+
+/// A bounded queue whose producer and consumers sleep until there is room or work
+template<typename T>
+class gfa_blocking_queue_t {
+public:
+    explicit gfa_blocking_queue_t(uint64_t capacity) : capacity(std::max(capacity, (uint64_t)1)) { }
+
+    /// Add an item, waiting while the queue is full
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [&]() { return items.size() < capacity; });
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+    }
+
+    /// Take an item, waiting while the queue is empty. Returns false once the
+    /// queue is closed and drained.
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [&]() { return !items.empty() || closed; });
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    /// Signal that no more items will be pushed
+    void close(void) {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        not_empty.notify_all();
+    }
+
+private:
+    uint64_t capacity;
+    bool closed = false;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+};
 
-std::map<char, uint64_t> gfa_line_counts(const char* filename);
+typedef gfa_blocking_queue_t<gfa_path_segment_t> gfa_path_queue_t;
 
-/// Fills a handle graph with an instantiation of a sequence graph from a GFA file.
-/// Handle graph must be empty when passed into function.
+/// Fills a graph with an instantiation of a sequence graph from a GFA file.
+/// The graph must be empty when passed into function. The file is memory-mapped
+/// and split into line-aligned chunks, which are parsed on n_threads threads in
+/// one pass to count records, one to build nodes and edges and one to build
+/// paths. A gzip or BGZF compressed file is parsed as it is inflated, BGZF on
+/// n_threads threads, a batch of a few MiB at a time, and is inflated again for
+/// each pass. Nothing is written to disk, and beyond the graph only a batch and
+/// the longest line of the file are held in memory.
 void gfa_to_handle(const string& gfa_filename,
-                   handlegraph::MutablePathMutableHandleGraph* graph,
+                   graph_t* graph,
                    uint64_t n_threads = 1,
                    bool show_progress = false);
 
@@ -0,0 +1,100 @@
+#pragma once
+
+/**
+ * \file lru_cache.hpp
+ *
+ * A byte-bounded cache of strings by string key that evicts the least
+ * recently used entries first. Values are shared, so a reader keeps the
+ * value it got even if the entry is evicted while it is still in use.
+ * All operations take one lock and are safe to call from many threads.
+ *
+ */
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace odgi {
+
+class lru_cache_t {
+public:
+    typedef std::shared_ptr<const std::string> value_t;
+
+    /// A cache holding up to capacity bytes of keys and values
+    explicit lru_cache_t(uint64_t capacity) : max_bytes(capacity) { }
+    lru_cache_t(const lru_cache_t& other) = delete;
+    lru_cache_t& operator=(const lru_cache_t& other) = delete;
+
+    /// The value cached for key, which becomes the most recently used, or null if there is none
+    value_t get(const std::string& key) {
+        std::lock_guard<std::mutex> guard(lock);
+        auto f = index.find(key);
+        if (f == index.end()) {
+            ++miss_count;
+            return nullptr;
+        }
+        ++hit_count;
+        entries.splice(entries.begin(), entries, f->second);
+        return f->second->second;
+    }
+
+    /// Cache the value for key as the most recently used, evicting the least recently used
+    /// entries to make room. A value that alone exceeds the capacity is not cached.
+    void put(const std::string& key, const value_t& value) {
+        const uint64_t entry_bytes = key.size() + value->size();
+        std::lock_guard<std::mutex> guard(lock);
+        auto f = index.find(key);
+        if (f != index.end()) {
+            used_bytes -= f->first.size() + f->second->second->size();
+            entries.erase(f->second);
+            index.erase(f);
+        }
+        if (entry_bytes > max_bytes) {
+            return;
+        }
+        while (used_bytes + entry_bytes > max_bytes) {
+            auto& last = entries.back();
+            used_bytes -= last.first.size() + last.second->size();
+            index.erase(last.first);
+            entries.pop_back();
+            ++eviction_count;
+        }
+        entries.emplace_front(key, value);
+        index[key] = entries.begin();
+        used_bytes += entry_bytes;
+    }
+
+    /// Drop all entries, keeping the counters
+    void clear(void) {
+        std::lock_guard<std::mutex> guard(lock);
+        index.clear();
+        entries.clear();
+        used_bytes = 0;
+    }
+
+    uint64_t hits(void) const { std::lock_guard<std::mutex> guard(lock); return hit_count; }
+    uint64_t misses(void) const { std::lock_guard<std::mutex> guard(lock); return miss_count; }
+    uint64_t evictions(void) const { std::lock_guard<std::mutex> guard(lock); return eviction_count; }
+    /// The number of cached entries
+    uint64_t size(void) const { std::lock_guard<std::mutex> guard(lock); return index.size(); }
+    /// The bytes of keys and values cached
+    uint64_t bytes(void) const { std::lock_guard<std::mutex> guard(lock); return used_bytes; }
+    uint64_t capacity(void) const { return max_bytes; }
+
+private:
+    const uint64_t max_bytes;
+    uint64_t used_bytes = 0;
+    uint64_t hit_count = 0;
+    uint64_t miss_count = 0;
+    uint64_t eviction_count = 0;
+    /// Keys and values, most recently used first
+    std::list<std::pair<std::string, value_t>> entries;
+    std::unordered_map<std::string, std::list<std::pair<std::string, value_t>>::iterator> index;
+    mutable std::mutex lock;
+};
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+/**
+ * \file membuf.hpp
+ *
+ * A read-only std::streambuf over a range of memory, so that stream-based
+ * loaders can decode directly out of a memory-mapped file without copying it.
+ *
+ */
+
+#include <streambuf>
+#include <istream>
+#include <cstdint>
+
+namespace odgi {
+
+struct membuf : public std::streambuf {
+    membuf(const char* begin, const char* end) {
+        char* b = const_cast<char*>(begin);
+        char* e = const_cast<char*>(end);
+        this->setg(b, b, e);
+    }
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode which = std::ios_base::in) override {
+        char* target = nullptr;
+        if (dir == std::ios_base::cur) {
+            target = gptr() + off;
+        } else if (dir == std::ios_base::end) {
+            target = egptr() + off;
+        } else {
+            target = eback() + off;
+        }
+        if (target < eback() || target > egptr()) {
+            return pos_type(off_type(-1));
+        }
+        setg(eback(), target, egptr());
+        return pos_type(target - eback());
+    }
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+/// An input stream reading from a fixed range of memory
+struct imemstream : virtual membuf, public std::istream {
+    imemstream(const char* begin, const char* end)
+        : membuf(begin, end),
+          std::istream(static_cast<std::streambuf*>(this)) { }
+};
+
+}
@@ -7,7 +7,7 @@ uint64_t node_t::sequence_size() const {
 }
 
 void node_t::set_sequence(const std::string& seq) {
-    sequence = seq;
+    sequence.assign(seq);
 }
 
 void node_t::set_id(const uint64_t& new_id) {
@@ -18,7 +18,11 @@ const uint64_t& node_t::get_id() const {
     return id;
 }
 
-const std::string& node_t::get_sequence() const {
+std::string node_t::get_sequence() const {
+    return sequence.str();
+}
+
+const packed_sequence_t& node_t::get_packed_sequence() const {
     return sequence;
 }
 
@@ -339,13 +343,21 @@ void node_t::copy(const node_t& other) {
     paths = other.paths;
 }
 
+void node_t::take(node_t& other) {
+    id = other.id;
+    sequence = std::move(other.sequence);
+    edges = std::move(other.edges);
+    decoding = std::move(other.decoding);
+    paths = std::move(other.paths);
+}
+
 void node_t::apply_ordering(
     const std::function<uint64_t(uint64_t)>& get_new_id,
     const std::function<bool(uint64_t)>& to_flip) {
     // flip the node sequence if needed
     bool flip = to_flip(id);
     if (flip) {
-        reverse_complement_in_place(sequence);
+        sequence.reverse_complement_in_place();
     }
     // rewrite the encoding (affects path storage)
     std::vector<uint64_t> dec_v;
@@ -419,11 +431,7 @@ void node_t::apply_path_ordering(
 
 uint64_t node_t::serialize(std::ostream& out) const {
     uint64_t written = 0;
-    size_t seq_size = sequence.size();
-    out.write((char*)&seq_size, sizeof(size_t));
-    written += sizeof(size_t);
-    out.write((char*)sequence.c_str(), seq_size*sizeof(char));
-    written += seq_size*sizeof(char);
+    written += sequence.serialize(out);
     out.write((char*)&id, sizeof(id));
     written += sizeof(id);
     written += edges.serialize(out);
@@ -432,20 +440,32 @@ uint64_t node_t::serialize(std::ostream& out) const {
     return written;
 }
 
-void node_t::load(std::istream& in) {
-    size_t len = 0;
-    in.read((char*)&len, sizeof(size_t));
-    sequence.resize(len);
-    in.read((char*)sequence.c_str(), len*sizeof(uint8_t));
+void node_t::load(std::istream& in, bool packed_sequence, bool load_paths) {
+    if (packed_sequence) {
+        sequence.load(in);
+    } else {
+        size_t len = 0;
+        in.read((char*)&len, sizeof(size_t));
+        std::string seq;
+        seq.resize(len);
+        in.read((char*)seq.data(), len*sizeof(uint8_t));
+        sequence.assign(seq);
+    }
     in.read((char*)&id, sizeof(id));
     edges.load(in);
     decoding.load(in); 
-    paths.load(in);
+    if (load_paths) {
+        paths.load(in);
+    }
     //display();
 }
 
+void node_t::load_paths(std::istream& in) {
+    paths.load(in);
+}
+
 void node_t::display() const {
-    std::cerr << "seq " << sequence << " "
+    std::cerr << "seq " << sequence.str() << " "
               << "edge_count " << edge_count() << " "
               << "path_count " << path_count();
     std::cerr << " | ";
@@ -14,6 +14,7 @@
 #include "dynamic.hpp"
 #include "varint.hpp"
 #include "dna.hpp"
+#include "packed_sequence.hpp"
 
 namespace odgi {
 
@@ -26,7 +27,7 @@ const uint8_t PATH_RECORD_LENGTH = 6;
 class node_t {
     uint64_t id = 0;
     std::atomic_flag lock = ATOMIC_FLAG_INIT;
-    std::string sequence;
+    packed_sequence_t sequence;
     dyn::hacked_vector edges;
     dyn::hacked_vector decoding;
     dyn::hacked_vector paths;
@@ -110,7 +111,9 @@ public:
     uint64_t decode(const uint64_t& idx) const;
 
     uint64_t sequence_size(void) const;
-    const std::string& get_sequence(void) const;
+    std::string get_sequence(void) const;
+    /// The stored sequence, for reading ranges or single bases without copying it all
+    const packed_sequence_t& get_packed_sequence(void) const;
     void set_sequence(const std::string& seq);
     const uint64_t& get_id(void) const;
     void set_id(const uint64_t& new_id);
@@ -170,9 +173,15 @@ public:
     void clear_paths(void);
     void clear_encoding(void);
     uint64_t serialize(std::ostream& out) const;
-    void load(std::istream& in);
+    /// Load a node record; records from before .og version 3 hold the sequence as plain bytes.
+    /// Without load_paths the stream is left at the path steps, which end the record.
+    void load(std::istream& in, bool packed_sequence = true, bool load_paths = true);
+    /// Load the path steps of a record whose load() skipped them
+    void load_paths(std::istream& in);
     void display(void) const;
     void copy(const node_t& other);
+    /// Move the contents of another node into this one
+    void take(node_t& other);
     void apply_ordering(
         const std::function<uint64_t(uint64_t)>& get_new_id,
         const std::function<bool(uint64_t)>& to_flip);
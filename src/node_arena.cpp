@@ -0,0 +1,50 @@
+#include "node_arena.hpp"
+
+namespace odgi {
+
+node_arena_t::slot_t* node_arena_t::add_slab(uint64_t count) {
+    slabs.emplace_back(new slot_t[count]);
+    slab_sizes.push_back(count);
+    return slabs.back().get();
+}
+
+node_t* node_arena_t::create(void) {
+    if (!free_slots.empty()) {
+        node_t* slot = free_slots.back();
+        free_slots.pop_back();
+        return construct(slot);
+    }
+    if (current_used == SLAB_SIZE) {
+        current = add_slab(SLAB_SIZE);
+        current_used = 0;
+    }
+    return construct((node_t*)&current[current_used++]);
+}
+
+node_t* node_arena_t::reserve(uint64_t count) {
+    if (count == 0) return nullptr;
+    return (node_t*)add_slab(count);
+}
+
+void node_arena_t::destroy(node_t* node) {
+    node->~node_t();
+    free_slots.push_back(node);
+}
+
+void node_arena_t::clear(void) {
+    slabs.clear();
+    slab_sizes.clear();
+    current = nullptr;
+    current_used = SLAB_SIZE;
+    free_slots.clear();
+}
+
+uint64_t node_arena_t::capacity_bytes(void) const {
+    uint64_t slots = 0;
+    for (auto& size : slab_sizes) {
+        slots += size;
+    }
+    return slots * sizeof(slot_t);
+}
+
+}
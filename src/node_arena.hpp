@@ -0,0 +1,58 @@
+#pragma once
+
+/**
+ * \file node_arena.hpp
+ *
+ * Slab storage for node_t records. Nodes are placed side by side in large
+ * blocks instead of each getting its own allocation, so that nodes created
+ * or loaded in id order are also adjacent in memory.
+ *
+ */
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <type_traits>
+#include "node.hpp"
+
+namespace odgi {
+
+class node_arena_t {
+public:
+    node_arena_t(void) = default;
+    node_arena_t(const node_arena_t& other) = delete;
+    node_arena_t& operator=(const node_arena_t& other) = delete;
+    node_arena_t(node_arena_t&& other) = default;
+    node_arena_t& operator=(node_arena_t&& other) = default;
+
+    /// Construct a node in the next free slot, reusing destroyed ones first.
+    /// Not thread safe.
+    node_t* create(void);
+    /// Set aside count contiguous slots, to be filled by construct() in any
+    /// order and from any thread. Not thread safe itself.
+    node_t* reserve(uint64_t count);
+    /// Construct a node in a slot obtained from reserve()
+    static inline node_t* construct(node_t* slot) {
+        return new (slot) node_t();
+    }
+    /// Destroy a node and make its slot available to create(). Not thread safe.
+    void destroy(node_t* node);
+    /// Release all slabs. Every node in them must have been destroyed.
+    void clear(void);
+    /// Bytes held in slabs
+    uint64_t capacity_bytes(void) const;
+
+private:
+    typedef std::aligned_storage<sizeof(node_t), alignof(node_t)>::type slot_t;
+    /// Nodes per slab filled by create()
+    static const uint64_t SLAB_SIZE = 1 << 12;
+    std::vector<std::unique_ptr<slot_t[]>> slabs;
+    std::vector<uint64_t> slab_sizes;
+    /// The slab filled by create() and how many of its slots are used
+    slot_t* current = nullptr;
+    uint64_t current_used = SLAB_SIZE;
+    std::vector<node_t*> free_slots;
+    slot_t* add_slab(uint64_t count);
+};
+
+}
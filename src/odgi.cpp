@@ -3,6 +3,12 @@
 //  
 
 #include "odgi.hpp"
+#include "membuf.hpp"
+#include <mio/mmap.hpp>
+#include <arpa/inet.h>
+#include <sstream>
+#include <algorithm>
+#include <tuple>
 
 namespace odgi {
 
@@ -42,11 +48,13 @@ uint64_t graph_t::get_node_rank(const nid_t& node_id) const {
 
 /// set the id increment, used when the graph starts at a high id to reduce loading costs
 void graph_t::set_id_increment(const nid_t& min_id) {
+    assert_mutable();
     _id_increment = min_id;
 }
 
 /// Increment node ids, using the builtin id increment, assumes we're increasing by a positive value
 void graph_t::increment_node_ids(nid_t increment) {
+    assert_mutable();
     _id_increment += increment;
 }
 
@@ -63,19 +71,54 @@ handle_t graph_t::flip(const handle_t& handle) const {
 /// Get the length of a node
 size_t graph_t::get_length(const handle_t& handle) const {
     auto& node = get_node_ref(handle);
-    node.get_lock();
+    get_read_lock(node);
     auto l = node.sequence_size();
-    node.clear_lock();
+    clear_read_lock(node);
     return l;
 }
 
 /// Get the sequence of a node, presented in the handle's local forward orientation.
 std::string graph_t::get_sequence(const handle_t& handle) const {
     auto& node = get_node_ref(handle);
-    node.get_lock();
-    auto seq = node.get_sequence();
-    node.clear_lock();
-    return (get_is_reverse(handle) ? reverse_complement(seq) : seq);
+    std::string seq;
+    get_read_lock(node);
+    auto& packed = node.get_packed_sequence();
+    if (get_is_reverse(handle)) {
+        packed.extract_reverse_complement(0, packed.size(), seq);
+    } else {
+        packed.extract(0, packed.size(), seq);
+    }
+    clear_read_lock(node);
+    return seq;
+}
+
+/// Get a base of a node in the handle's orientation, without decoding the rest of it
+char graph_t::get_base(const handle_t& handle, size_t index) const {
+    auto& node = get_node_ref(handle);
+    get_read_lock(node);
+    auto& packed = node.get_packed_sequence();
+    char base = (get_is_reverse(handle)
+                 ? reverse_complement(packed.at(packed.size() - index - 1))
+                 : packed.at(index));
+    clear_read_lock(node);
+    return base;
+}
+
+/// Get a range of a node's sequence in the handle's orientation, decoding only that range
+std::string graph_t::get_subsequence(const handle_t& handle, size_t index, size_t size) const {
+    auto& node = get_node_ref(handle);
+    std::string seq;
+    get_read_lock(node);
+    auto& packed = node.get_packed_sequence();
+    index = std::min(index, (size_t)packed.size());
+    size = std::min(size, (size_t)packed.size() - index);
+    if (get_is_reverse(handle)) {
+        packed.extract_reverse_complement(packed.size() - index - size, size, seq);
+    } else {
+        packed.extract(index, size, seq);
+    }
+    clear_read_lock(node);
+    return seq;
 }
 
 /// Loop over all the handles to next/previous (right/left) nodes. Passes
@@ -194,23 +237,14 @@ edge_t graph_t::edge_handle(const handle_t& left, const handle_t& right) const {
 ////////////////////////////////////////////////////////////////////////////
 
 graph_t::path_metadata_t& graph_t::get_path_metadata(const path_handle_t& path) const {
-    graph_t::path_metadata_t* p;
-    if (path_metadata_h->Find(as_integer(path), p)) {
-        return *p;
-    } else {
-        assert(false);
-        return *p; // won't reach unless assert is disabled
-    }
+    assert(as_integer(path) > 0 && as_integer(path) <= _path_handle_next);
+    auto& p = path_metadata_table[as_integer(path)];
+    assert(p.handle.load() == path);
+    return p;
 }
 
 const graph_t::path_metadata_t& graph_t::path_metadata(const path_handle_t& path) const {
-    graph_t::path_metadata_t* p;
-    if (path_metadata_h->Find(as_integer(path), p)) {
-        return *p;
-    } else {
-        assert(false);
-        return *p; // won't reach unless assert is disabled
-    }
+    return get_path_metadata(path);
 }
 
 /// Determine if a path name exists and is legal to get a path handle for.
@@ -249,9 +283,11 @@ size_t graph_t::get_path_count() const {
 /// Execute a function on each path in the graph
 bool graph_t::for_each_path_handle_impl(const std::function<bool(const path_handle_t&)>& iteratee) const {
     bool flag = true;
-    for (uint64_t i = 1; i <= _path_handle_next; ++i) {
-        path_metadata_t* p;
-        if (path_metadata_h->Find(i, p)) {
+    uint64_t path_handle_next = _path_handle_next;
+    for (uint64_t i = 1; i <= path_handle_next; ++i) {
+        // a path being created on another thread may not have its slot yet
+        if (!path_metadata_table.contains(i)) break;
+        if (as_integer(path_metadata_table[i].handle.load()) != 0) {
             flag &= iteratee(as_path_handle(i));
         }
     }
@@ -259,6 +295,7 @@ bool graph_t::for_each_path_handle_impl(const std::function<bool(const path_hand
 }
 
 bool graph_t::for_each_step_on_handle_impl(const handle_t& handle, const std::function<bool(const step_handle_t&)>& iteratee) const {
+    ensure_path_steps();
     uint64_t handle_n = number_bool_packing::unpack_number(handle);
     const node_t& node = get_node_cref(handle);
     bool flag = true;
@@ -290,10 +327,11 @@ std::vector<step_handle_t> graph_t::steps_of_handle(const handle_t& handle,
 }
 
 size_t graph_t::get_step_count(const handle_t& handle) const {
+    ensure_path_steps();
     auto& node = get_node_ref(handle);
-    node.get_lock();
+    get_read_lock(node);
     auto count = node.path_count();
-    node.clear_lock();
+    clear_read_lock(node);
     return count;
 }
 
@@ -304,10 +342,11 @@ handle_t graph_t::get_handle_of_step(const step_handle_t& step_handle) const {
 
 /// Get a path handle (path ID) from a handle to an step on a path
 path_handle_t graph_t::get_path(const step_handle_t& step_handle) const {
+    ensure_path_steps();
     auto& node = get_node_ref(get_handle_of_step(step_handle));
-    node.get_lock();
+    get_read_lock(node);
     auto p = node.get_path_step(as_integers(step_handle)[1]).path_id;
-    node.clear_lock();
+    clear_read_lock(node);
     return as_path_handle(p);
 }
 
@@ -346,24 +385,27 @@ bool graph_t::get_is_circular(const path_handle_t& path_handle) const {
 
 /// set the circular flag for the path
 void graph_t::set_circularity(const path_handle_t& path_handle, bool circular) {
+    assert_mutable();
     get_path_metadata(path_handle).is_circular = circular;
 }
 
 /// Returns true if the step is not the last step on the path, else false
 bool graph_t::has_next_step(const step_handle_t& step_handle) const {
+    ensure_path_steps();
     auto& node = get_node_ref(get_handle_of_step(step_handle));
-    node.get_lock();
+    get_read_lock(node);
     auto b = !node.step_is_end(as_integers(step_handle)[1]);
-    node.clear_lock();
+    clear_read_lock(node);
     return b;
 }
 
 /// Returns true if the step is not the first step on the path, else false
 bool graph_t::has_previous_step(const step_handle_t& step_handle) const {
+    ensure_path_steps();
     auto& node = get_node_ref(get_handle_of_step(step_handle));
-    node.get_lock();
+    get_read_lock(node);
     auto b = !node.step_is_start(as_integers(step_handle)[1]);
-    node.clear_lock();
+    clear_read_lock(node);
     return b;
 }
 
@@ -378,6 +420,7 @@ bool graph_t::is_path_end(const step_handle_t& step_handle) const {
 /// Returns a handle to the next step on the path
 /// Returns the forward end iterator if none exists
 step_handle_t graph_t::get_next_step(const step_handle_t& step_handle) const {
+    ensure_path_steps();
     handle_t curr_handle;
     // check if we have a magic path iterator step handle
     if (is_path_front_end(step_handle)) {
@@ -389,20 +432,20 @@ step_handle_t graph_t::get_next_step(const step_handle_t& step_handle) const {
     }
     nid_t curr_id = get_id(curr_handle);
     node_t& node = get_node_ref(curr_handle);
-    node.get_lock();
+    get_read_lock(node);
     auto step_rank = as_integers(step_handle)[1];
     if (node.step_is_end(step_rank)) {
-        node.clear_lock();
+        clear_read_lock(node);
         return path_end(get_path_handle_of_step(step_handle));
     }
     nid_t next_id = node.step_next_id(step_rank);
     auto next_rank = node.step_next_rank(step_rank);
-    node.clear_lock();
+    clear_read_lock(node);
     handle_t next_handle = get_handle(next_id);
     node_t& next = get_node_ref(next_handle);
-    next.get_lock();
+    get_read_lock(next);
     bool next_rev = next.step_is_rev(next_rank);
-    next.clear_lock();
+    clear_read_lock(next);
     step_handle_t next_step;
     as_integers(next_step)[0] = as_integer(get_handle(next_id, next_rev));
     as_integers(next_step)[1] = next_rank;
@@ -411,6 +454,7 @@ step_handle_t graph_t::get_next_step(const step_handle_t& step_handle) const {
 
 /// Returns a handle to the previous step on the path
 step_handle_t graph_t::get_previous_step(const step_handle_t& step_handle) const {
+    ensure_path_steps();
     handle_t curr_handle;
     // check if we have a magic path iterator step handle
     if (is_path_front_end(step_handle)) {
@@ -422,20 +466,20 @@ step_handle_t graph_t::get_previous_step(const step_handle_t& step_handle) const
     }
     nid_t curr_id = get_id(curr_handle);
     node_t& node = get_node_ref(curr_handle);
-    node.get_lock();
+    get_read_lock(node);
     auto step_rank = as_integers(step_handle)[1];
     if (node.step_is_start(step_rank)) {
-        node.clear_lock();
+        clear_read_lock(node);
         return path_front_end(get_path_handle_of_step(step_handle));
     }
     nid_t prev_id = node.step_prev_id(step_rank);
     auto prev_rank = node.step_prev_rank(step_rank);
-    node.clear_lock();
+    clear_read_lock(node);
     handle_t prev_handle = get_handle(prev_id);
     node_t& prev = get_node_ref(prev_handle);
-    prev.get_lock();
+    get_read_lock(prev);
     bool prev_rev = prev.step_is_rev(prev_rank);
-    prev.clear_lock();
+    clear_read_lock(prev);
     step_handle_t prev_step;
     as_integers(prev_step)[0] = as_integer(get_handle(prev_id, prev_rev));
     as_integers(prev_step)[1] = prev_rank;
@@ -443,10 +487,11 @@ step_handle_t graph_t::get_previous_step(const step_handle_t& step_handle) const
 }
 
 path_handle_t graph_t::get_path_handle_of_step(const step_handle_t& step_handle) const {
+    ensure_path_steps();
     node_t& node = get_node_ref(get_handle_of_step(step_handle));
-    node.get_lock();
+    get_read_lock(node);
     auto path = as_path_handle(node.step_path_id(as_integers(step_handle)[1]));
-    node.clear_lock();
+    clear_read_lock(node);
     return path;
 }
 
@@ -489,6 +534,51 @@ void graph_t::for_each_step_in_path(const path_handle_t& path, const std::functi
     } while (keep_going);
 }
 
+/// Loop over the handles visited by a path, from first through last
+void graph_t::for_each_handle_in_path(const path_handle_t& path, const std::function<void(const handle_t&)>& iteratee) const {
+    // one pass over the steps is cheaper than building an array to scan once
+    if (_frozen && _path_handle_arrays[as_integer(path)].ready.load(std::memory_order_acquire)) {
+        for (auto& handle : _path_handle_arrays[as_integer(path)].handles) {
+            iteratee(handle);
+        }
+    } else {
+        for_each_step_in_path(path, [&](const step_handle_t& step) {
+            iteratee(get_handle_of_step(step));
+        });
+    }
+}
+
+/// Get the handles visited by a path as a contiguous array, building it on first use
+const std::vector<handle_t>& graph_t::get_path_handles(const path_handle_t& path) const {
+    if (!_frozen) {
+        throw std::runtime_error("[odgi::graph_t] error: path handle arrays are only available on a frozen graph.");
+    }
+    auto& array = _path_handle_arrays[as_integer(path)];
+    std::call_once(array.built, [&]() {
+        array.handles.reserve(get_step_count(path));
+        for_each_step_in_path(path, [&](const step_handle_t& step) {
+            array.handles.push_back(get_handle_of_step(step));
+        });
+        array.ready.store(true, std::memory_order_release);
+    });
+    return array.handles;
+}
+
+/// Build the handle arrays of all paths in parallel
+void graph_t::build_path_handle_arrays() {
+    if (!_frozen) {
+        throw std::runtime_error("[odgi::graph_t] error: path handle arrays are only available on a frozen graph.");
+    }
+    std::vector<path_handle_t> paths;
+    for_each_path_handle([&](const path_handle_t& path) {
+        paths.push_back(path);
+    });
+#pragma omp parallel for schedule(dynamic, 1) num_threads(_num_threads)
+    for (uint64_t i = 0; i < paths.size(); ++i) {
+        get_path_handles(paths[i]);
+    }
+}
+
 /// Create a new node with the given sequence and return the handle.
 handle_t graph_t::create_handle(const std::string& sequence) {
     // get first deleted node to recycle
@@ -502,6 +592,7 @@ handle_t graph_t::create_handle(const std::string& sequence) {
 
 /// Create a new node with the given id and sequence, then return the handle.
 handle_t graph_t::create_handle(const std::string& sequence, const nid_t& id) {
+    assert_mutable();
     assert(sequence.size());
     assert(id > 0);
     assert(!has_node(id));
@@ -531,13 +622,55 @@ handle_t graph_t::create_handle(const std::string& sequence, const nid_t& id) {
         assert(deleted_nodes.count(id));
         deleted_nodes.erase(id);
     }
-    n = new node_t();
+    n = node_arena.create();
     auto& node = *n;
     node.set_id(id);
     node.set_sequence(sequence);
     return number_bool_packing::pack(handle_rank, 0);
 }
 
+/// Make room for nodes with ids up to max_id before a concurrent bulk load
+void graph_t::prepare_bulk_nodes(const nid_t& max_id) {
+    assert_mutable();
+    if (max_id > node_v.size()) {
+        // the new nodes get one contiguous slab, in id order
+        _bulk_base = node_v.size();
+        _bulk_slab = node_arena.reserve((uint64_t)max_id - _bulk_base);
+        node_v.resize((uint64_t)max_id, nullptr);
+    }
+}
+
+/// Create a node in prepared space; distinct ids touch distinct slots, so no locking is needed
+handle_t graph_t::create_bulk_handle(const std::string& sequence, const nid_t& id) {
+    assert(sequence.size());
+    assert(id > 0 && id <= node_v.size());
+    uint64_t handle_rank = (uint64_t)id-1;
+    assert(_bulk_slab != nullptr && handle_rank >= _bulk_base);
+    auto* n = node_arena_t::construct(_bulk_slab + (handle_rank - _bulk_base));
+    n->set_id(id);
+    n->set_sequence(sequence);
+    node_v[handle_rank] = n;
+    return number_bool_packing::pack(handle_rank, 0);
+}
+
+/// Rebuild the deleted node set and the id bounds after a bulk load
+void graph_t::finish_bulk_nodes() {
+    _bulk_slab = nullptr;
+    _bulk_base = 0;
+    deleted_nodes.clear();
+    _min_node_id = 0;
+    _max_node_id = 0;
+    for (uint64_t i = 0; i < node_v.size(); ++i) {
+        nid_t id = i+1;
+        if (node_v[i] == nullptr) {
+            deleted_nodes.insert(id);
+        } else {
+            if (!_min_node_id) _min_node_id = id;
+            _max_node_id = id;
+        }
+    }
+}
+
 /// Remove the node belonging to the given handle and all of its edges.
 /// Does not update any stored paths.
 /// Invalidates the destroyed handle.
@@ -545,6 +678,7 @@ handle_t graph_t::create_handle(const std::string& sequence, const nid_t& id) {
 /// May **NOT** be called during parallel for_each_handle iteration.
 /// May **NOT** be called on the node from which edges are being followed during follow_edges.
 void graph_t::destroy_handle(const handle_t& handle) {
+    assert_mutable();
     handle_t fwd_handle = get_is_reverse(handle) ? flip(handle) : handle;
     uint64_t id = get_id(handle);
     if (!has_node(id)) return; // deleted already
@@ -564,8 +698,13 @@ void graph_t::destroy_handle(const handle_t& handle) {
         destroy_edge(edge);
     }
     // clear the node storage
-    auto& node = node_v[number_bool_packing::unpack_number(handle)];
-    delete node;
+    uint64_t rank = number_bool_packing::unpack_number(handle);
+    auto& node = node_v[rank];
+    if (_path_steps_deferred.load() && rank < _deferred_path_steps->positions.size()) {
+        // a node created later in this slot must not pick up these steps
+        _deferred_path_steps->positions[rank] = 0;
+    }
+    node_arena.destroy(node);
     // remove from the graph
     node = nullptr;
     // add the index to our list of open node slots
@@ -597,6 +736,7 @@ void graph_t::rebuild_id_handle_mapping() {
 /// Create an edge connecting the given handles in the given order and orientations.
 /// Ignores existing edges.
 void graph_t::create_edge(const handle_t& left_h, const handle_t& right_h) {
+    assert_mutable();
     uint64_t left_rank = number_bool_packing::unpack_number(left_h);
     uint64_t right_rank = number_bool_packing::unpack_number(right_h);
     bool create_edge = false;
@@ -643,6 +783,125 @@ void graph_t::create_edge(const handle_t& left_h, const handle_t& right_h) {
     }
 }
 
+/// Create many edges at once, grouping them by node so that no locks are needed
+void graph_t::create_edges(const std::vector<edge_t>& edges) {
+    assert_mutable();
+    // Each edge is recorded on both of its nodes, or once on its node if it is a self loop.
+    // We describe each side in the form where the edge leaves the node, as the node's rank
+    // and strand and the handle it leads to, so that equal edges compare equal whichever
+    // strand they were given on. A self loop leaves its node both ways, so it takes the
+    // lesser form. The order is the index of the edge in the input and whether the side is
+    // the edge read from its reverse strand. Keeping the first of equal sides and adding
+    // them in input order stores every node's edges as a create_edge loop would.
+    struct half_edge_t {
+        uint64_t side;
+        uint64_t other;
+        uint64_t order;
+    };
+    const uint64_t n_threads = std::max(_num_threads, (uint64_t)1);
+    const uint64_t n_buckets = n_threads * 8;
+    const uint64_t rank_count = std::max(node_v.size(), (size_t)1);
+    auto bucket_of = [&](uint64_t rank) {
+        return rank * n_buckets / rank_count;
+    };
+    auto rank_of = [](uint64_t h) {
+        return number_bool_packing::unpack_number(as_handle(h));
+    };
+    std::vector<std::vector<std::vector<half_edge_t>>> sides(
+        n_threads, std::vector<std::vector<half_edge_t>>(n_buckets));
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+    for (uint64_t t = 0; t < n_threads; ++t) {
+        // contiguous slices keep the grouped order independent of scheduling
+        uint64_t begin = edges.size() * t / n_threads;
+        uint64_t end = edges.size() * (t + 1) / n_threads;
+        auto& local = sides[t];
+        for (uint64_t i = begin; i < end; ++i) {
+            const uint64_t left = as_integer(edges[i].first);
+            const uint64_t right = as_integer(edges[i].second);
+            // the edge read from the reverse strand
+            const uint64_t rev_left = as_integer(flip(edges[i].second));
+            const uint64_t rev_right = as_integer(flip(edges[i].first));
+            if (rank_of(left) == rank_of(right)) {
+                auto& bucket = local[bucket_of(rank_of(left))];
+                if (std::tie(rev_left, rev_right) < std::tie(left, right)) {
+                    bucket.push_back({ rev_left, rev_right, (i << 1) | 1 });
+                } else {
+                    bucket.push_back({ left, right, i << 1 });
+                }
+                continue;
+            }
+            local[bucket_of(rank_of(left))].push_back({ left, right, i << 1 });
+            local[bucket_of(rank_of(rev_left))].push_back({ rev_left, rev_right, (i << 1) | 1 });
+        }
+    }
+    std::atomic<uint64_t> sides_added(0);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+    for (uint64_t b = 0; b < n_buckets; ++b) {
+        std::vector<half_edge_t> bucket;
+        for (uint64_t t = 0; t < n_threads; ++t) {
+            auto& part = sides[t][b];
+            bucket.insert(bucket.end(), part.begin(), part.end());
+            std::vector<half_edge_t>().swap(part);
+        }
+        // keep the first of equal sides, then put each node's sides back in input order
+        std::sort(bucket.begin(), bucket.end(), [](const half_edge_t& x, const half_edge_t& y) {
+                return std::tie(x.side, x.other, x.order) < std::tie(y.side, y.other, y.order);
+            });
+        bucket.erase(std::unique(bucket.begin(), bucket.end(), [](const half_edge_t& x, const half_edge_t& y) {
+                    return x.side == y.side && x.other == y.other;
+                }), bucket.end());
+        std::sort(bucket.begin(), bucket.end(), [&](const half_edge_t& x, const half_edge_t& y) {
+                return std::make_pair(rank_of(x.side), x.order) < std::make_pair(rank_of(y.side), y.order);
+            });
+        uint64_t added = 0;
+        std::vector<std::pair<uint64_t, uint64_t>> existing;
+        for (uint64_t i = 0; i < bucket.size(); ) {
+            const uint64_t rank = rank_of(bucket[i].side);
+            node_t& node = get_node_ref(as_handle(bucket[i].side));
+            // collect the edges the node already has, in the same form
+            existing.clear();
+            node.for_each_edge([&](uint64_t other_id, bool other_rev, bool to_curr, bool on_rev) {
+                handle_t other = get_handle(other_id, other_rev);
+                handle_t side = number_bool_packing::pack(rank, on_rev);
+                if (to_curr) {
+                    existing.emplace_back(as_integer(flip(side)), as_integer(flip(other)));
+                } else {
+                    existing.emplace_back(as_integer(side), as_integer(other));
+                    if (number_bool_packing::unpack_number(other) == rank) {
+                        existing.emplace_back(as_integer(flip(other)), as_integer(flip(side)));
+                    }
+                }
+                return true;
+            });
+            for ( ; i < bucket.size() && rank_of(bucket[i].side) == rank; ++i) {
+                const half_edge_t& half = bucket[i];
+                if (!existing.empty()
+                    && std::find(existing.begin(), existing.end(), std::make_pair(half.side, half.other)) != existing.end()) {
+                    continue;
+                }
+                // back to the edge as it was given
+                handle_t left = as_handle(half.side);
+                handle_t right = as_handle(half.other);
+                if (half.order & 1) {
+                    left = flip(as_handle(half.other));
+                    right = flip(as_handle(half.side));
+                }
+                // stored as create_edge stores it: on the left node, and on the right one unless it is a self loop
+                if (number_bool_packing::unpack_number(left) == rank) {
+                    node.add_edge(get_id(right), get_is_reverse(right), false, get_is_reverse(left));
+                    added += number_bool_packing::unpack_number(right) == rank ? 2 : 1;
+                } else {
+                    node.add_edge(get_id(left), get_is_reverse(left), true, get_is_reverse(right));
+                    ++added;
+                }
+            }
+        }
+        sides_added += added;
+    }
+    // both sides of an edge are added or skipped together, and a self loop counts as both
+    _edge_count += sides_added / 2;
+}
+
 /*
 uint64_t graph_t::edge_delta_to_id(uint64_t base, uint64_t delta) const {
     //assert(delta != 0);
@@ -670,6 +929,7 @@ bool graph_t::has_edge(const handle_t& left, const handle_t& right) const {
 /// Ignores nonexistent edges.
 /// Does not update any stored paths.
 void graph_t::destroy_edge(const handle_t& left_h, const handle_t& right_h) {
+    assert_mutable();
     auto& left_node = get_node_ref(left_h);
     auto& right_node =  get_node_ref(right_h);
     bool left_rev = get_is_reverse(left_h);
@@ -681,28 +941,34 @@ void graph_t::destroy_edge(const handle_t& left_h, const handle_t& right_h) {
 
 /// Remove all nodes and edges. Does not update any stored paths.
 void graph_t::clear() {
+    _frozen = false;
+    _path_handle_arrays.reset();
+    _path_steps_deferred = false;
+    _deferred_path_steps.reset();
     suc_bv null_bv;
     _max_node_id = 0;
     _min_node_id = 0;
     _edge_count = 0;
     deleted_nodes.clear();
     for (auto& n : node_v) {
-        delete n;
+        if (n != nullptr) node_arena.destroy(n);
     }
     node_v.clear();
+    node_arena.clear();
     for_each_path_handle(
         [&](const path_handle_t& p) {
-            // remove from both hash tables
-            auto s = get_path_name(p);
-            delete &get_path_metadata(p);
-            path_metadata_h->Delete(as_integer(p));
-            path_name_h->Delete(s);
+            path_name_h->Delete(get_path_name(p));
         });
+    path_metadata_table.clear();
     _path_count = 0;
     _path_handle_next = 0;
 }
 
 void graph_t::clear_paths() {
+    assert_mutable();
+    // steps still in the file are dropped along with the rest
+    _path_steps_deferred = false;
+    _deferred_path_steps.reset();
     for_each_handle(
         [&](const handle_t& handle) {
             node_t& node = get_node_ref(handle);
@@ -710,12 +976,9 @@ void graph_t::clear_paths() {
         });
     for_each_path_handle(
         [&](const path_handle_t& p) {
-            // remove from both hash tables
-            auto s = get_path_name(p);
-            delete &get_path_metadata(p);
-            path_metadata_h->Delete(as_integer(p));
-            path_name_h->Delete(s);
+            path_name_h->Delete(get_path_name(p));
         });
+    path_metadata_table.clear();
     _path_count = 0;
     _path_handle_next = 0;
 }
@@ -771,6 +1034,8 @@ void graph_t::reassign_node_ids(const std::function<nid_t(const nid_t&)>& get_ne
 /// Reorder the graph's internal structure to match that given.
 /// Optionally compact the id space of the graph to match the ordering, from 1->|ordering|.
 void graph_t::apply_ordering(const std::vector<handle_t>& order_in, bool compact_ids) {
+    assert_mutable();
+    ensure_path_steps();
     // get mapping from old to new id
     // if we're given an empty order, just compact the ids based on our ordering
     const std::vector<handle_t>* order;
@@ -827,33 +1092,21 @@ void graph_t::apply_ordering(const std::vector<handle_t>& order_in, bool compact
     // path metadata
 #pragma omp parallel for schedule(static, 1) num_threads(_num_threads)
     for (uint64_t i = 1; i <= _path_handle_next; ++i) {
-        path_metadata_t* p;
-        if (path_metadata_h->Find(i, p)) {
-            const auto& path = as_path_handle(i);
-            auto& old_meta = path_metadata(as_path_handle(i));
-            path_metadata_h->Delete(as_integer(path));
-            path_name_h->Delete(p->name);
-            p = new path_metadata_t();
-            p->handle.store(old_meta.handle); // same by def
-            p->length.store(old_meta.length); // same
-            // reassign the handle ids
-            step_handle_t f = old_meta.first.load();
+        auto& p = path_metadata_table[i];
+        if (as_integer(p.handle.load()) != 0) {
+            // reassign the handle ids in place
+            step_handle_t f = p.first.load();
             handle_t& f_h = as_handle((uint64_t&)as_integers(f)[0]);
             uint64_t f_id = get_id(f_h);
             f_h = number_bool_packing::pack(get_new_id(f_id)-1, // note -1
                                             get_is_reverse(f_h)^to_flip(f_id));
-            p->first.store(f);
-            step_handle_t l = old_meta.last.load();
+            p.first.store(f);
+            step_handle_t l = p.last.load();
             handle_t& l_h = as_handle((uint64_t&)as_integers(l)[0]);
             uint64_t l_id = get_id(l_h);
             l_h = number_bool_packing::pack(get_new_id(l_id)-1, // note -1
                                             get_is_reverse(l_h)^to_flip(l_id));
-            p->last.store(l);
-            p->name = old_meta.name;
-            p->is_circular.store(old_meta.is_circular);
-            path_metadata_h->Insert(as_integer(path), p);
-            path_name_h->Insert(p->name, p);
-            delete &old_meta;
+            p.last.store(l);
         }
     }
 
@@ -880,11 +1133,27 @@ void graph_t::apply_ordering(const std::vector<handle_t>& order_in, bool compact
         }
         _max_node_id = new_node_v.size();
     }
+    // lay the records out in their new order, so that nodes that are close in
+    // the order are also close in memory
+    node_arena_t arena;
+    node_t* slots = arena.reserve(new_node_v.size());
+#pragma omp parallel for schedule(static) num_threads(_num_threads)
+    for (uint64_t i = 0; i < new_node_v.size(); ++i) {
+        node_t* old_node = new_node_v[i];
+        if (old_node != nullptr) {
+            new_node_v[i] = node_arena_t::construct(slots + i);
+            new_node_v[i]->take(*old_node);
+            old_node->~node_t();
+        }
+    }
+    node_arena = std::move(arena);
     node_v = new_node_v;
     deleted_nodes.clear();
 }
 
 void graph_t::apply_path_ordering(const std::vector<path_handle_t>& order) {
+    assert_mutable();
+    ensure_path_steps();
     std::vector<path_handle_t> curr_to_new(order.size());
     {
         uint64_t i = 0;
@@ -897,20 +1166,26 @@ void graph_t::apply_path_ordering(const std::vector<path_handle_t>& order) {
             return curr_to_new[as_integer(p)-1];
         };
     // now we save our metadata
-    std::vector<path_metadata_t*> metadata;
-    metadata.reserve(_path_count.load());
-    // then we'll apply this to our metadata map in parallel
+    std::vector<path_handle_t> paths;
+    paths.reserve(_path_count.load());
     for_each_path_handle(
         [&](const path_handle_t& path) {
-            auto& p_m = get_path_metadata(path);
-            assert(p_m.handle == path);
-            // update our internal handle
-            p_m.handle.store(get_new_path_handle(path));
-            metadata.push_back(&p_m);
-            path_metadata_h->Delete(as_integer(path));
+            paths.push_back(path);
         });
-    for (auto* m : metadata) {
-        path_metadata_h->Insert(as_integer(m->handle), m);
+    std::unique_ptr<path_metadata_t[]> metadata(new path_metadata_t[paths.size()]());
+    for (uint64_t i = 0; i < paths.size(); ++i) {
+        auto& p_m = get_path_metadata(paths[i]);
+        metadata[i].copy(p_m);
+        path_name_h->Delete(p_m.name);
+        p_m.reset();
+    }
+    // then put each record in the slot of its new handle
+    for (uint64_t i = 0; i < paths.size(); ++i) {
+        path_handle_t path = get_new_path_handle(paths[i]);
+        auto& p_m = path_metadata_table[as_integer(path)];
+        p_m.copy(metadata[i]);
+        p_m.handle.store(path);
+        path_name_h->Insert(p_m.name, &p_m);
     }
     // and to the nodes in parallel
     auto get_new_path_id =
@@ -936,6 +1211,8 @@ void graph_t::apply_path_ordering(const std::vector<path_handle_t>& order) {
 /// Updates all stored paths. May change the ordering of the underlying
 /// graph.
 handle_t graph_t::apply_orientation(const handle_t& handle) {
+    assert_mutable();
+    ensure_path_steps();
     // do nothing if we're already in the right orientation
     if (!get_is_reverse(handle)) return handle;
     handle_t fwd_handle = flip(handle);
@@ -1010,6 +1287,7 @@ handle_t graph_t::apply_orientation(const handle_t& handle) {
 }
 
 void graph_t::set_handle_sequence(const handle_t& handle, const std::string& seq) {
+    assert_mutable();
     assert(seq.size());
     auto& node = get_node_ref(handle);
     node.get_lock();
@@ -1025,6 +1303,7 @@ void graph_t::set_handle_sequence(const handle_t& handle, const std::string& seq
 /// passed in.
 /// Updates stored paths.
 std::vector<handle_t> graph_t::divide_handle(const handle_t& handle, const std::vector<size_t>& offsets) {
+    ensure_path_steps();
     // convert the offsets to the forward strand, if needed
     std::vector<uint64_t> fwd_offsets = { 0 };
     uint64_t length = get_length(handle);
@@ -1180,6 +1459,7 @@ handle_t graph_t::combine_handles(const std::vector<handle_t>& handles) {
  * Destroy the given path. Invalidates handles to the path and its node steps.
  */
 void graph_t::destroy_path(const path_handle_t& path) {
+    assert_mutable();
     // select everything with that handle in the path_handle_wt
     std::vector<step_handle_t> path_v;
     for_each_step_in_path(path, [this,&path_v](const step_handle_t& step) {
@@ -1193,9 +1473,8 @@ void graph_t::destroy_path(const path_handle_t& path) {
     auto& p = get_path_metadata(path);
     // our length should be 0
     assert(p.length == 0);
-    path_metadata_h->Delete(as_integer(p.handle));
     path_name_h->Delete(p.name);
-    delete &p;
+    p.reset();
     --_path_count;
 }
 
@@ -1206,8 +1485,10 @@ void graph_t::destroy_path(const path_handle_t& path) {
  * remain valid.
  */
 path_handle_t graph_t::create_path_handle(const std::string& name, bool is_circular) {
+    assert_mutable();
     path_handle_t path = as_path_handle(++_path_handle_next);
-    path_metadata_t* _p = new path_metadata_t();
+    path_metadata_table.reserve(as_integer(path) + 1);
+    path_metadata_t* _p = &path_metadata_table[as_integer(path)];
     auto& p = *_p;
     step_handle_t step;
     p.handle = path;
@@ -1219,13 +1500,13 @@ path_handle_t graph_t::create_path_handle(const std::string& name, bool is_circu
     p.name = name;
     p.is_circular = is_circular;
     ++_path_count; // atomic
-    path_metadata_h->Insert(as_integer(path), _p);
     path_name_h->Insert(name, _p);
-    auto& q = path_metadata(path);
     return path;
 }
 
 step_handle_t graph_t::create_step(const path_handle_t& path, const handle_t& handle) {
+    assert_mutable();
+    ensure_path_steps();
     // where are we going to insert?
     auto& node = get_node_ref(handle);
     node.get_lock();
@@ -1242,6 +1523,8 @@ step_handle_t graph_t::create_step(const path_handle_t& path, const handle_t& ha
 }
 
 void graph_t::link_steps(const step_handle_t& from, const step_handle_t& to) {
+    assert_mutable();
+    ensure_path_steps();
     path_handle_t path = get_path(from);
     assert(path == get_path(to));
     const handle_t& from_handle = get_handle_of_step(from);
@@ -1263,6 +1546,8 @@ void graph_t::link_steps(const step_handle_t& from, const step_handle_t& to) {
 }
 
 void graph_t::destroy_step(const step_handle_t& step_handle) {
+    assert_mutable();
+    ensure_path_steps();
     // erase reference to this step
     bool has_prev = has_previous_step(step_handle);
     bool has_next = has_next_step(step_handle);
@@ -1326,10 +1611,37 @@ step_handle_t graph_t::append_step(const path_handle_t& path, const handle_t& to
     return new_step;
 }
 
+std::pair<step_handle_t, step_handle_t> graph_t::create_path_segment(const path_handle_t& path,
+                                                                     const std::vector<handle_t>& handles) {
+    assert(!handles.empty());
+    step_handle_t first = create_step(path, handles.front());
+    step_handle_t last = first;
+    for (uint64_t i = 1; i < handles.size(); ++i) {
+        step_handle_t step = create_step(path, handles[i]);
+        link_steps(last, step);
+        last = step;
+    }
+    return std::make_pair(first, last);
+}
+
+void graph_t::append_path_segment(const path_handle_t& path,
+                                  const std::pair<step_handle_t, step_handle_t>& segment,
+                                  uint64_t length) {
+    auto& p = get_path_metadata(path);
+    if (!p.length) {
+        p.first.store(segment.first);
+    } else {
+        link_steps(path_back(path), segment.first);
+    }
+    p.last.store(segment.second);
+    p.length += length;
+}
+
 /// helper to handle the case where we remove an step from a given path
 /// on a node that has other steps from the same path, thus invalidating the
 /// ranks used to refer to it
 void graph_t::decrement_rank(const step_handle_t& step_handle) {
+    ensure_path_steps();
     // what is the actual rank of this step?
     //std::cerr << "in decrement rank " << get_handle_of_step(step_handle) << ":" << as_integers(step_handle)[1] << std::endl;
     if (has_previous_step(step_handle)) {
@@ -1373,6 +1685,7 @@ step_handle_t graph_t::insert_step(const step_handle_t& before, const step_handl
 
 /// reassign the given step to the new handle
 step_handle_t graph_t::set_step(const step_handle_t& step_handle, const handle_t& assign_to) {
+    ensure_path_steps();
     return rewrite_segment(step_handle, step_handle, { assign_to }).first;
 }
 
@@ -1462,6 +1775,7 @@ handle_t graph_t::rank_to_handle(const size_t &rank) const {
 }
 
 void graph_t::display() const {
+    ensure_path_steps();
     std::cerr << "------ graph state ------" << std::endl;
 
     std::cerr << "_max_node_id = " << _max_node_id << std::endl;
@@ -1529,53 +1843,131 @@ void graph_t::display() const {
 }
 
 void graph_t::to_gfa(std::ostream& out) const {
-    out << "H\tVN:Z:1.0" << std::endl;
-    // for each node
-    for_each_handle([&out,this](const handle_t& h) {
-            out << "S\t" << get_id(h) << "\t"
-                << get_sequence(h) << "\t"
-                << "DP:i:" << get_step_count(h) << "\t"
-                << "RC:i:" << get_step_count(h) * get_length(h) << std::endl;
-            {
-                // use this direct iteration to avoid double counting edges
-                // we only consider write the edges relative to their start
-                const node_t& node = get_node_cref(h);
-                bool is_rev = get_is_reverse(h);
-                nid_t node_id = get_id(h);
-                node.for_each_edge(
-                    [&](nid_t other_id,
-                        bool other_rev,
-                        bool to_curr,
-                        bool on_rev) {
-                        if (!to_curr) {
-                            out << "L\t" << node_id << "\t"
-                                << (on_rev?"-":"+") << "\t"
-                                << other_id << "\t"
-                                << (other_rev?"-":"+") << "\t"
-                                << "0M" << std::endl;
-                        }
-                        return true;
-                    });
+    // records are formatted into one buffer per piece of the graph, a round of
+    // pieces at a time on all threads, and each round is written in order
+    const uint64_t num_threads = std::max(_num_threads, (uint64_t)1);
+    const uint64_t round_size = num_threads * 4;
+    std::vector<std::string> buffers(round_size);
+    auto write_pieces =
+        [&](uint64_t piece_count, const std::function<void(uint64_t, std::string&)>& format) {
+            for (uint64_t round = 0; round < piece_count; round += round_size) {
+                uint64_t round_end = std::min(round + round_size, piece_count);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+                for (uint64_t i = round; i < round_end; ++i) {
+                    auto& buffer = buffers[i - round];
+                    buffer.clear();
+                    format(i, buffer);
+                }
+                for (uint64_t i = round; i < round_end; ++i) {
+                    out.write(buffers[i - round].data(), buffers[i - round].size());
+                }
             }
-        });
-    for_each_path_handle([&out,this](const path_handle_t& p) {
-            out << "P\t" << get_path_name(p) << "\t";
-            auto& path_meta = path_metadata(p);
-            uint64_t i = 0;
-            for_each_step_in_path(p, [this,&i,&out](const step_handle_t& step) {
-                    handle_t h = get_handle_of_step(step);
-                    out << get_id(h) << (get_is_reverse(h)?"-":"+");
-                    if (has_next_step(step)) out << ",";
-                    ++i;
+        };
+
+    out << "H\tVN:Z:1.0\n";
+    // each node with the edges that start on it, in rank order
+    const uint64_t node_piece_size = 1 << 14;
+    write_pieces((node_v.size() + node_piece_size - 1) / node_piece_size,
+                 [&](uint64_t piece, std::string& buffer) {
+        uint64_t last = std::min((piece + 1) * node_piece_size, (uint64_t)node_v.size());
+        for (uint64_t i = piece * node_piece_size; i < last; ++i) {
+            handle_t h = number_bool_packing::pack(i, false);
+            if (is_deleted(h)) continue;
+            nid_t node_id = get_id(h);
+            std::string id_str = std::to_string(node_id);
+            uint64_t step_count = get_step_count(h);
+            buffer.append("S\t").append(id_str).append("\t")
+                .append(get_sequence(h)).append("\t")
+                .append("DP:i:").append(std::to_string(step_count)).append("\t")
+                .append("RC:i:").append(std::to_string(step_count * get_length(h))).append("\n");
+            // use this direct iteration to avoid double counting edges
+            // we only consider write the edges relative to their start
+            const node_t& node = get_node_cref(h);
+            node.for_each_edge(
+                [&](nid_t other_id,
+                    bool other_rev,
+                    bool to_curr,
+                    bool on_rev) {
+                    if (!to_curr) {
+                        buffer.append("L\t").append(id_str).append("\t")
+                            .append(on_rev?"-":"+").append("\t")
+                            .append(std::to_string(other_id)).append("\t")
+                            .append(other_rev?"-":"+").append("\t")
+                            .append("0M\n");
+                    }
+                    return true;
                 });
-            out << "\t" << "*"; // always put at least a "*" in the overlaps field
+        }
+    });
+
+    // a path is one piece, unless it is long enough to be sliced so that it spreads
+    // over all threads; each slice walks its steps from the step it begins at, which
+    // we find in one walk over the path
+    struct path_piece_t {
+        path_handle_t path;
+        uint64_t begin;
+        uint64_t end;
+        step_handle_t start;
+    };
+    const uint64_t path_piece_steps = 1 << 20;
+    std::vector<path_handle_t> paths;
+    for_each_path_handle([&](const path_handle_t& p) {
+        paths.push_back(p);
+    });
+    std::vector<std::vector<step_handle_t>> piece_starts(paths.size());
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+    for (uint64_t i = 0; i < paths.size(); ++i) {
+        uint64_t length = get_step_count(paths[i]);
+        if (length > path_piece_steps) {
+            auto& starts = piece_starts[i];
+            starts.reserve((length + path_piece_steps - 1) / path_piece_steps);
+            step_handle_t step = path_begin(paths[i]);
+            for (uint64_t j = 0; j < length; ++j) {
+                if (j % path_piece_steps == 0) {
+                    starts.push_back(step);
+                }
+                step = get_next_step(step);
+            }
+        }
+    }
+    std::vector<path_piece_t> path_pieces;
+    for (uint64_t i = 0; i < paths.size(); ++i) {
+        uint64_t length = get_step_count(paths[i]);
+        if (piece_starts[i].empty()) {
+            path_pieces.push_back({paths[i], 0, length, path_begin(paths[i])});
+        } else {
+            for (uint64_t b = 0; b < length; b += path_piece_steps) {
+                path_pieces.push_back({paths[i], b, std::min(b + path_piece_steps, length),
+                                       piece_starts[i][b / path_piece_steps]});
+            }
+        }
+    }
+    piece_starts.clear();
+    write_pieces(path_pieces.size(), [&](uint64_t piece, std::string& buffer) {
+        auto& path_piece = path_pieces[piece];
+        const path_handle_t& p = path_piece.path;
+        uint64_t length = get_step_count(p);
+        if (path_piece.begin == 0) {
+            buffer.append("P\t").append(get_path_name(p)).append("\t");
+        }
+        step_handle_t step = path_piece.start;
+        for (uint64_t i = path_piece.begin; i < path_piece.end; ++i) {
+            handle_t h = get_handle_of_step(step);
+            buffer.append(std::to_string(get_id(h))).append(get_is_reverse(h)?"-":"+");
+            if (i + 1 < length) {
+                buffer.push_back(',');
+                step = get_next_step(step);
+            }
+        }
+        if (path_piece.end == length) {
+            buffer.append("\t*"); // always put at least a "*" in the overlaps field
             if (get_is_circular(p)) {
-                out << "\t" << "TP:Z:circular";
+                buffer.append("\tTP:Z:circular");
             }
-            assert(i == path_meta.length);
-            //out << "\t" << "steps:i:" << path_meta.length;
-            out << std::endl;
-        });
+            buffer.push_back('\n');
+        }
+    });
+    out.flush();
 }
 
 uint32_t graph_t::get_magic_number() const {
@@ -1583,8 +1975,14 @@ uint32_t graph_t::get_magic_number() const {
 }
 
 void graph_t::serialize_members(std::ostream& out) const {
+    ensure_path_steps();
     //rebuild_id_handle_mapping();
     uint64_t written = 0;
+    og_footer_t footer;
+    out.write((char*)&OG_FORMAT_MARKER,sizeof(OG_FORMAT_MARKER));
+    written += sizeof(OG_FORMAT_MARKER);
+    out.write((char*)&OG_FORMAT_VERSION,sizeof(OG_FORMAT_VERSION));
+    written += sizeof(OG_FORMAT_VERSION);
     out.write((char*)&_max_node_id,sizeof(_max_node_id));
     written += sizeof(_max_node_id);
     out.write((char*)&_min_node_id,sizeof(_min_node_id));
@@ -1600,41 +1998,197 @@ void graph_t::serialize_members(std::ostream& out) const {
     written += sizeof(_path_handle_next);
     out.write((char*)&_id_increment,sizeof(_id_increment));
     written += sizeof(_id_increment);
+    uint64_t chunk_size = OG_NODE_CHUNK_SIZE;
+    out.write((char*)&chunk_size,sizeof(chunk_size));
+    written += sizeof(chunk_size);
     //assert(node_count == node_v.size());
     // hack
     // todo big mess, middle of removal of deleted node bv
-    node_t empty_node;
-    for (auto& node : node_v) {
-        // check if node is null
-        if (node == nullptr) {
-            written += empty_node.serialize(out);
-        } else {
-            written += node->serialize(out);
+    // encode the node records in chunks, a round of _num_threads chunks at a time,
+    // then write each round out in order so that only one round is ever buffered
+    footer.sections[OG_NODE_RECORDS] = written;
+    uint64_t chunk_count = (node_count + chunk_size - 1) / chunk_size;
+    uint64_t num_threads = std::max(_num_threads, (uint64_t)1);
+    std::vector<uint64_t> node_offsets(node_count+1);
+    std::vector<uint64_t> chunk_offsets(chunk_count+1);
+    std::vector<std::string> chunk_buffers(num_threads);
+    const node_t empty_node;
+    for (uint64_t round = 0; round < chunk_count; round += num_threads) {
+        uint64_t round_end = std::min(round + num_threads, chunk_count);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+        for (uint64_t c = round; c < round_end; ++c) {
+            std::stringstream chunk_out;
+            uint64_t chunk_written = 0;
+            uint64_t last = std::min((c+1)*chunk_size, node_count);
+            for (uint64_t i = c*chunk_size; i < last; ++i) {
+                // relative to the chunk until we know where it lands
+                node_offsets[i] = chunk_written;
+                // check if node is null
+                if (node_v[i] == nullptr) {
+                    chunk_written += empty_node.serialize(chunk_out);
+                } else {
+                    chunk_written += node_v[i]->serialize(chunk_out);
+                }
+            }
+            chunk_buffers[c - round] = chunk_out.str();
+        }
+        for (uint64_t c = round; c < round_end; ++c) {
+            auto& chunk = chunk_buffers[c - round];
+            chunk_offsets[c] = written - footer.sections[OG_NODE_RECORDS];
+            uint64_t chunk_bytes = chunk.size();
+            out.write((char*)&chunk_bytes,sizeof(chunk_bytes));
+            written += sizeof(chunk_bytes);
+            uint64_t last = std::min((c+1)*chunk_size, node_count);
+            for (uint64_t i = c*chunk_size; i < last; ++i) {
+                node_offsets[i] += written - footer.sections[OG_NODE_RECORDS];
+            }
+            out.write(chunk.c_str(),chunk_bytes);
+            written += chunk_bytes;
+            std::string().swap(chunk);
         }
     }
-    // there are _path_count of these to write
-    uint64_t j = 0;
+    node_offsets[node_count] = written - footer.sections[OG_NODE_RECORDS];
+    chunk_offsets[chunk_count] = written - footer.sections[OG_NODE_RECORDS];
+    // the offset tables let a mapped reader find any node record or chunk directly
+    footer.sections[OG_NODE_OFFSETS] = written;
+    out.write((char*)node_offsets.data(),node_offsets.size()*sizeof(uint64_t));
+    written += node_offsets.size()*sizeof(uint64_t);
+    footer.sections[OG_NODE_CHUNKS] = written;
+    out.write((char*)chunk_offsets.data(),chunk_offsets.size()*sizeof(uint64_t));
+    written += chunk_offsets.size()*sizeof(uint64_t);
+    // there are _path_count of these to write, we encode them in parallel
+    // and prefix them with their offsets so readers can decode them in parallel
+    footer.sections[OG_PATH_METADATA] = written;
+    std::vector<path_handle_t> paths;
+    paths.reserve(_path_count);
     for_each_path_handle(
         [&](const path_handle_t& path) {
-            auto& m = path_metadata(path);
-            out.write((char*)&m.length,sizeof(m.length));
-            written += sizeof(m.length);
-            out.write((char*)&m.first,sizeof(m.first));
-            written += sizeof(m.first);
-            out.write((char*)&m.last,sizeof(m.last));
-            written += sizeof(m.last);
-            size_t k = m.name.size();
-            out.write((char*)&k,sizeof(k));
-            written += sizeof(k);
-            out.write((char*)m.name.c_str(),m.name.size());
-            written += k;
-            ++j;
+            paths.push_back(path);
         });
-    assert(j == _path_count);
+    assert(paths.size() == _path_count);
+    std::vector<std::string> path_records(paths.size());
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+    for (uint64_t j = 0; j < paths.size(); ++j) {
+        std::stringstream path_out;
+        auto& m = path_metadata(paths[j]);
+        path_out.write((char*)&m.length,sizeof(m.length));
+        path_out.write((char*)&m.first,sizeof(m.first));
+        path_out.write((char*)&m.last,sizeof(m.last));
+        size_t k = m.name.size();
+        path_out.write((char*)&k,sizeof(k));
+        path_out.write((char*)m.name.c_str(),m.name.size());
+        path_records[j] = path_out.str();
+    }
+    std::vector<uint64_t> path_offsets(paths.size()+1);
+    for (uint64_t j = 0; j < paths.size(); ++j) {
+        path_offsets[j+1] = path_offsets[j] + path_records[j].size();
+    }
+    out.write((char*)path_offsets.data(),path_offsets.size()*sizeof(uint64_t));
+    written += path_offsets.size()*sizeof(uint64_t);
+    for (auto& record : path_records) {
+        out.write(record.c_str(),record.size());
+        written += record.size();
+    }
+    // totals, so that a summary can be read without loading the graph
+    og_summary_t summary;
+    uint64_t live_nodes = 0;
+    uint64_t sequence_length = 0;
+#pragma omp parallel for schedule(static) num_threads(num_threads) reduction(+:live_nodes,sequence_length)
+    for (uint64_t i = 0; i < node_count; ++i) {
+        if (node_v[i] != nullptr) {
+            ++live_nodes;
+            sequence_length += node_v[i]->sequence_size();
+        }
+    }
+    summary.node_count = live_nodes;
+    summary.sequence_length = sequence_length;
+    // counted as for_each_edge visits them, so that odgi stats -S reads what it would count
+    std::atomic<uint64_t> edge_count(0);
+    for_each_edge([&](const edge_t& e) {
+            ++edge_count;
+            return true;
+        }, true);
+    summary.edge_count = edge_count.load();
+    summary.path_count = _path_count;
+    for (auto& path : paths) {
+        summary.step_count += path_metadata(path).length;
+    }
+    summary.min_node_id = min_node_id();
+    summary.max_node_id = max_node_id();
+    footer.sections[OG_SUMMARY] = written;
+    out.write((char*)&summary,sizeof(summary));
+    written += sizeof(summary);
+    out.write((char*)&footer,sizeof(footer));
+    written += sizeof(footer);
+}
+
+void graph_t::load_node_range(std::istream& in, uint64_t from, uint64_t to, std::vector<uint64_t>& deleted,
+                              uint64_t version, const uint64_t* record_offsets, uint64_t* path_positions) {
+    bool packed_sequence = version >= OG_PACKED_SEQUENCE_VERSION;
+    for (uint64_t i = from; i < to; ++i) {
+        node_v[i] = node_arena_t::construct(_bulk_slab + (i - _bulk_base));
+        auto& node = node_v[i];
+        if (record_offsets) {
+            // the path steps end the record, so we jump over them to the next one
+            in.seekg(record_offsets[i - from]);
+            node->load(in, packed_sequence, false);
+            path_positions[i - from] = node->get_id() ? (uint64_t)in.tellg() : 0;
+        } else {
+            node->load(in, packed_sequence);
+        }
+        if (node->get_id() == 0) {
+            // detect which nodes are deleted
+            // these must be the only ones with id == 0
+            // they have been stored as empty node records
+            // their slots go back to the arena in release_deleted_slots, as it is not thread safe
+            node = nullptr;
+            deleted.push_back(i+1);
+        }
+    }
+}
+
+void graph_t::load_path_metadata(std::istream& in, const path_handle_t& path) {
+    // the caller has reserved the slot
+    path_metadata_t* _p = &path_metadata_table[as_integer(path)];
+    auto& m = *_p;
+    m.handle = path;
+    in.read((char*)&m.length,sizeof(m.length));
+    in.read((char*)&m.first,sizeof(m.first));
+    in.read((char*)&m.last,sizeof(m.last));
+    uint64_t s;
+    in.read((char*)&s,sizeof(s));
+    m.name.resize(s);
+    in.read((char*)m.name.data(),s);
+    path_name_h->Insert(m.name, _p);
+}
+
+void graph_t::load_path_metadata_range(const char* records, const uint64_t* offsets, uint64_t count) {
+    // each path fills its own slot, and the name table takes concurrent inserts
+    path_metadata_table.reserve(count + 1);
+#pragma omp parallel for schedule(dynamic, 64) num_threads(std::max(_num_threads, (uint64_t)1))
+    for (uint64_t j = 0; j < count; ++j) {
+        imemstream path_in(records + offsets[j], records + offsets[j+1]);
+        load_path_metadata(path_in, as_path_handle(j+1));
+    }
 }
 
 void graph_t::deserialize_members(std::istream& in) {
-    in.read((char*)&_max_node_id,sizeof(_max_node_id));
+    assert_mutable();
+    // versioned files begin with a marker where legacy files stored _max_node_id
+    uint64_t marker = 0;
+    uint64_t version = 0;
+    in.read((char*)&marker,sizeof(marker));
+    if (marker == OG_FORMAT_MARKER) {
+        in.read((char*)&version,sizeof(version));
+        if (version > OG_FORMAT_VERSION) {
+            throw std::runtime_error("[odgi::graph_t] error: graph was written in .og format version "
+                                     + std::to_string(version) + ", but this odgi only reads up to version "
+                                     + std::to_string(OG_FORMAT_VERSION) + ".");
+        }
+        in.read((char*)&_max_node_id,sizeof(_max_node_id));
+    } else {
+        _max_node_id = marker;
+    }
     in.read((char*)&_min_node_id,sizeof(_min_node_id));
     uint64_t node_count = node_v.size();
     in.read((char*)&node_count,sizeof(node_count));
@@ -1643,36 +2197,244 @@ void graph_t::deserialize_members(std::istream& in) {
     in.read((char*)&_path_handle_next,sizeof(_path_handle_next));
     in.read((char*)&_id_increment,sizeof(_id_increment));
     node_v.resize(node_count,nullptr);
-    for (size_t i = 0; i < node_count; ++i) {
-        node_v[i] = new node_t;
-        auto& node = node_v[i];
-        node->load(in);
-        if (node->get_id() == 0) {
-            // detect which nodes are deleted
-            // these must be the only ones with id == 0
-            // they have been stored as empty node records
-            delete node;
-            node = nullptr;
-            deleted_nodes.insert(i+1);
+    // the records are loaded into one slab, in id order
+    _bulk_base = 0;
+    _bulk_slab = node_arena.reserve(node_count);
+    std::vector<uint64_t> deleted;
+    if (version < 2) {
+        load_node_range(in, 0, node_count, deleted, version);
+        if (version == 1) {
+            // a streaming reader has no use for the node offset table
+            in.ignore((node_count+1)*sizeof(uint64_t));
+        }
+        path_metadata_table.reserve(_path_count + 1);
+        for (size_t j = 0; j < _path_count; ++j) {
+            load_path_metadata(in, as_path_handle(j+1));
         }
+        if (version == 1) {
+            in.ignore(4*sizeof(uint64_t)); // the version 1 footer
+        }
+    } else {
+        uint64_t chunk_size = 0;
+        in.read((char*)&chunk_size,sizeof(chunk_size));
+        if (chunk_size == 0) {
+            throw std::runtime_error("error: Serialized handle graph does not match deserialzation type.");
+        }
+        uint64_t chunk_count = (node_count + chunk_size - 1) / chunk_size;
+        // read a round of chunks, then decode them in parallel
+        uint64_t num_threads = std::max(_num_threads, (uint64_t)1);
+        std::vector<std::string> chunk_buffers(num_threads);
+        std::vector<std::vector<uint64_t>> chunk_deleted(num_threads);
+        for (uint64_t round = 0; round < chunk_count; round += num_threads) {
+            uint64_t round_end = std::min(round + num_threads, chunk_count);
+            for (uint64_t c = round; c < round_end; ++c) {
+                uint64_t chunk_bytes = 0;
+                in.read((char*)&chunk_bytes,sizeof(chunk_bytes));
+                auto& chunk = chunk_buffers[c - round];
+                chunk.resize(chunk_bytes);
+                in.read((char*)chunk.data(),chunk_bytes);
+            }
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+            for (uint64_t c = round; c < round_end; ++c) {
+                auto& chunk = chunk_buffers[c - round];
+                imemstream chunk_in(chunk.data(), chunk.data() + chunk.size());
+                load_node_range(chunk_in, c*chunk_size, std::min((c+1)*chunk_size, node_count),
+                                chunk_deleted[c - round], version);
+            }
+            for (auto& d : chunk_deleted) {
+                deleted.insert(deleted.end(), d.begin(), d.end());
+                d.clear();
+            }
+        }
+        // a streaming reader has no use for the offset tables
+        in.ignore((node_count+1)*sizeof(uint64_t));
+        in.ignore((chunk_count+1)*sizeof(uint64_t));
+        std::vector<uint64_t> path_offsets(_path_count+1);
+        in.read((char*)path_offsets.data(),path_offsets.size()*sizeof(uint64_t));
+        std::string path_records;
+        path_records.resize(path_offsets.back());
+        in.read((char*)path_records.data(),path_records.size());
+        load_path_metadata_range(path_records.data(), path_offsets.data(), _path_count);
+        // the summary only repeats what we have loaded
+        uint64_t section_count = OG_SUMMARY;
+        if (version >= OG_SUMMARY_VERSION) {
+            in.ignore(sizeof(og_summary_t));
+            section_count = OG_SECTION_COUNT;
+        }
+        // the footer holds one offset per section, its section count and the marker
+        in.ignore((section_count + 2)*sizeof(uint64_t));
+    }
+    deleted_nodes.insert(deleted.begin(), deleted.end());
+    release_deleted_slots(deleted);
+    _bulk_slab = nullptr;
+}
+
+void graph_t::release_deleted_slots(const std::vector<uint64_t>& deleted) {
+    for (auto& id : deleted) {
+        node_arena.destroy(_bulk_slab + (id - 1 - _bulk_base));
+    }
+}
+
+/// A mapped file kept open so that the path steps left in it can be decoded later
+struct graph_t::deferred_path_steps_t {
+    mio::mmap_source mmap;
+    /// Where the path steps of each node record start, from the beginning of
+    /// the serialized members, or 0 if the node has none left to load
+    std::vector<uint64_t> positions;
+    const char* begin = nullptr;
+};
+
+void graph_t::set_deferred_path_steps(bool defer) {
+    _defer_path_steps = defer;
+}
+
+void graph_t::load_path_steps(void) const {
+    std::lock_guard<std::mutex> guard(_deferred_path_steps_lock);
+    if (!_path_steps_deferred.load(std::memory_order_relaxed)) return;
+    auto& deferred = *_deferred_path_steps;
+    const char* end = deferred.mmap.data() + deferred.mmap.size();
+    uint64_t count = std::min((uint64_t)deferred.positions.size(), (uint64_t)node_v.size());
+#pragma omp parallel for schedule(dynamic, 1024) num_threads(std::max(_num_threads, (uint64_t)1))
+    for (uint64_t i = 0; i < count; ++i) {
+        if (deferred.positions[i] && node_v[i] != nullptr) {
+            imemstream in(deferred.begin + deferred.positions[i], end);
+            node_v[i]->load_paths(in);
+        }
+    }
+    _deferred_path_steps.reset();
+    _path_steps_deferred.store(false, std::memory_order_release);
+}
+
+void graph_t::deserialize_mmap(const std::string& filename) {
+    std::error_code error;
+    mio::mmap_source mmap = mio::make_mmap_source(filename, error);
+    if (error) {
+        throw std::runtime_error("[odgi::graph_t] error: could not map \"" + filename + "\": " + error.message());
+    }
+    uint32_t magic_number = 0;
+    if (mmap.size() < sizeof(magic_number)) {
+        throw std::runtime_error("[odgi::graph_t] error: \"" + filename + "\" is too short to be a graph in ODGI format.");
+    }
+    std::memcpy(&magic_number, mmap.data(), sizeof(magic_number));
+    if (ntohl(magic_number) != get_magic_number()) {
+        throw std::runtime_error("error: Serialized handle graph does not match deserialzation type.");
+    }
+    if (!_defer_path_steps) {
+        deserialize_members(mmap.data() + sizeof(magic_number), mmap.data() + mmap.size());
+        return;
     }
-    for (size_t j = 0; j < _path_count; ++j) {
-        path_metadata_t* _p = new path_metadata_t();
-        auto& m = *_p;
-        m.handle = as_path_handle(j+1);
-        in.read((char*)&m.length,sizeof(m.length));
-        in.read((char*)&m.first,sizeof(m.first));
-        in.read((char*)&m.last,sizeof(m.last));
-        uint64_t s;
-        in.read((char*)&s,sizeof(s));
-        char n[s+1]; n[s] = '\0';
-        in.read(n,s);
-        m.name = string(n);
-        path_metadata_h->Insert(as_integer(m.handle), _p);
-        path_name_h->Insert(m.name, _p);
+    auto deferred = std::make_shared<deferred_path_steps_t>();
+    deserialize_members(mmap.data() + sizeof(magic_number), mmap.data() + mmap.size(), deferred.get());
+    if (!deferred->positions.empty()) {
+        // moving the mapping keeps it at the same address
+        deferred->mmap = std::move(mmap);
+        _deferred_path_steps = deferred;
+        _path_steps_deferred.store(true, std::memory_order_release);
     }
 }
 
+void graph_t::deserialize_members(const char* begin, const char* end) {
+    deserialize_members(begin, end, nullptr);
+}
+
+void graph_t::deserialize_members(const char* begin, const char* end, deferred_path_steps_t* deferred) {
+    assert_mutable();
+    uint64_t marker = 0;
+    uint64_t version = 0;
+    if (end - begin >= (int64_t)(2*sizeof(uint64_t) + sizeof(og_footer_t))) {
+        std::memcpy(&marker, begin, sizeof(marker));
+        std::memcpy(&version, begin + sizeof(marker), sizeof(version));
+    }
+    og_footer_t footer;
+    if (marker == OG_FORMAT_MARKER && version >= 2) {
+        // the footer ends with its section count and the marker, preceded by the section offsets
+        uint64_t section_count = 0;
+        std::memcpy(&footer.marker, end - sizeof(uint64_t), sizeof(uint64_t));
+        std::memcpy(&section_count, end - 2*sizeof(uint64_t), sizeof(uint64_t));
+        if (section_count <= (uint64_t)(end - begin)/sizeof(uint64_t) - 2) {
+            std::memcpy(footer.sections, end - (2 + section_count)*sizeof(uint64_t),
+                        std::min(section_count, (uint64_t)OG_SECTION_COUNT)*sizeof(uint64_t));
+        } else {
+            // the offsets would begin before the file does
+            footer.marker = 0;
+        }
+    }
+    if (marker != OG_FORMAT_MARKER || version < 2 || footer.marker != OG_FORMAT_MARKER) {
+        // legacy or truncated layout, fall back to decoding it as a stream
+        imemstream in(begin, end);
+        deserialize_members(in);
+        return;
+    }
+    // the fixed-width header
+    imemstream in(begin, begin + footer.sections[OG_NODE_RECORDS]);
+    in.read((char*)&marker,sizeof(marker));
+    in.read((char*)&version,sizeof(version));
+    if (version > OG_FORMAT_VERSION) {
+        throw std::runtime_error("[odgi::graph_t] error: graph was written in .og format version "
+                                 + std::to_string(version) + ", but this odgi only reads up to version "
+                                 + std::to_string(OG_FORMAT_VERSION) + ".");
+    }
+    in.read((char*)&_max_node_id,sizeof(_max_node_id));
+    in.read((char*)&_min_node_id,sizeof(_min_node_id));
+    uint64_t node_count = 0;
+    in.read((char*)&node_count,sizeof(node_count));
+    in.read((char*)&_edge_count,sizeof(_edge_count));
+    in.read((char*)&_path_count,sizeof(_path_count));
+    in.read((char*)&_path_handle_next,sizeof(_path_handle_next));
+    in.read((char*)&_id_increment,sizeof(_id_increment));
+    uint64_t chunk_size = 0;
+    in.read((char*)&chunk_size,sizeof(chunk_size));
+    if (chunk_size == 0) {
+        throw std::runtime_error("error: Serialized handle graph does not match deserialzation type.");
+    }
+    uint64_t chunk_count = (node_count + chunk_size - 1) / chunk_size;
+    // node records, decoded chunk by chunk in parallel straight out of the mapping
+    const char* node_records = begin + footer.sections[OG_NODE_RECORDS];
+    const uint64_t* chunk_offsets = (const uint64_t*)(begin + footer.sections[OG_NODE_CHUNKS]);
+    node_v.resize(node_count,nullptr);
+    // the records are loaded into one slab, in id order
+    _bulk_base = 0;
+    _bulk_slab = node_arena.reserve(node_count);
+    uint64_t num_threads = std::max(_num_threads, (uint64_t)1);
+    std::vector<std::vector<uint64_t>> chunk_deleted(chunk_count);
+    const uint64_t* node_offsets = (const uint64_t*)(begin + footer.sections[OG_NODE_OFFSETS]);
+    if (deferred) {
+        deferred->begin = begin;
+        deferred->positions.resize(node_count);
+    }
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+    for (uint64_t c = 0; c < chunk_count; ++c) {
+        uint64_t chunk_begin = chunk_offsets[c] + sizeof(uint64_t);
+        imemstream chunk_in(node_records + chunk_begin, node_records + chunk_offsets[c+1]);
+        uint64_t from = c*chunk_size;
+        uint64_t to = std::min((c+1)*chunk_size, node_count);
+        if (deferred) {
+            // offsets within the chunk, and path positions from the start of the members
+            std::vector<uint64_t> record_offsets(to - from);
+            for (uint64_t i = from; i < to; ++i) {
+                record_offsets[i - from] = node_offsets[i] - chunk_begin;
+            }
+            uint64_t* path_positions = deferred->positions.data() + from;
+            load_node_range(chunk_in, from, to, chunk_deleted[c], version,
+                            record_offsets.data(), path_positions);
+            for (uint64_t i = from; i < to; ++i) {
+                if (path_positions[i - from]) {
+                    path_positions[i - from] += footer.sections[OG_NODE_RECORDS] + chunk_begin;
+                }
+            }
+        } else {
+            load_node_range(chunk_in, from, to, chunk_deleted[c], version);
+        }
+    }
+    for (auto& d : chunk_deleted) {
+        deleted_nodes.insert(d.begin(), d.end());
+        release_deleted_slots(d);
+    }
+    _bulk_slab = nullptr;
+    // path metadata
+    const uint64_t* path_offsets = (const uint64_t*)(begin + footer.sections[OG_PATH_METADATA]);
+    load_path_metadata_range((const char*)(path_offsets + _path_count + 1), path_offsets, _path_count);
+}
 
 void graph_t::set_number_of_threads(uint64_t num_threads) {
     _num_threads = num_threads;
@@ -1682,19 +2444,38 @@ uint64_t graph_t::get_number_of_threads() {
     return _num_threads;
 }
 
+void graph_t::freeze() {
+    if (!_frozen) {
+        // path handles are drawn from a counter, so they index directly
+        _path_handle_arrays.reset(new path_handle_array_t[_path_handle_next + 1]);
+    }
+    _frozen = true;
+}
+
+void graph_t::thaw() {
+    _frozen = false;
+    _path_handle_arrays.reset();
+}
+
+bool graph_t::is_frozen() const {
+    return _frozen;
+}
+
 void graph_t::copy(const graph_t& other) {
     clear();
+    other.ensure_path_steps();
     _max_node_id.store(other._max_node_id);
     _min_node_id.store(other._min_node_id);
     _edge_count.store(other._edge_count);
     _path_count.store(other._path_count);
     _path_handle_next.store(other._path_handle_next);
     _id_increment.store(other._id_increment);
-    node_v.resize(other.node_v.size());
+    node_v.resize(other.node_v.size(), nullptr);
+    node_t* slots = node_arena.reserve(other.node_v.size());
     for (size_t i = 0; i < other.node_v.size(); ++i) {
-        node_v[i] = new node_t;
-        auto* node = node_v[i];
-        node->copy(other.get_node_cref(as_handle(i)));
+        if (other.node_v[i] == nullptr) continue;
+        node_v[i] = node_arena_t::construct(slots + i);
+        node_v[i]->copy(*other.node_v[i]);
     }
     deleted_nodes = other.deleted_nodes;
     // copy the path metadata
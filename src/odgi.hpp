@@ -31,10 +31,14 @@
 #include "dna.hpp"
 #include "hash_map.hpp"
 #include "node.hpp"
+#include "node_arena.hpp"
+#include "dense_table.hpp"
 
 #include <omp.h>
 #include "atomic_bitvector.hpp"
+#include <atomic>
 #include <mutex>
+#include <stdexcept>
 
 namespace odgi {
 
@@ -43,14 +47,53 @@ using namespace handlegraph;
 // Resolve ambiguous nid_t typedef by putting it in our namespace.
 using nid_t = handlegraph::nid_t;
 
+/// Written where legacy .og files stored _max_node_id, to mark a versioned layout
+const uint64_t OG_FORMAT_MARKER = 0x746d72666967646f; // "odgifrmt"
+/// The newest .og layout we write and can read
+const uint64_t OG_FORMAT_VERSION = 4;
+/// The first .og layout whose node records hold 2-bit packed sequences
+const uint64_t OG_PACKED_SEQUENCE_VERSION = 3;
+/// The first .og layout with an OG_SUMMARY section
+const uint64_t OG_SUMMARY_VERSION = 4;
+/// Nodes per independently encoded chunk of node records
+const uint64_t OG_NODE_CHUNK_SIZE = 1 << 14;
+
+/// Sections of a versioned .og file, in the order their offsets appear in the footer
+enum og_section_t : uint64_t {
+    OG_NODE_RECORDS = 0, // chunks of node_t records, each preceded by its size in bytes
+    OG_NODE_OFFSETS,     // node_v.size()+1 offsets of each node record relative to OG_NODE_RECORDS
+    OG_NODE_CHUNKS,      // chunk count+1 offsets of each chunk relative to OG_NODE_RECORDS
+    OG_PATH_METADATA,    // path_count+1 offsets of each record, then the path names and endpoints
+    OG_SUMMARY,          // an og_summary_t, from version 4
+    OG_SECTION_COUNT
+};
+
+/// Totals written with a graph so that summaries need not load it
+struct og_summary_t {
+    uint64_t node_count = 0;      // live nodes
+    uint64_t edge_count = 0;
+    uint64_t path_count = 0;
+    uint64_t step_count = 0;      // over all paths
+    uint64_t sequence_length = 0; // over all nodes
+    nid_t min_node_id = 0;        // as seen through get_id
+    nid_t max_node_id = 0;
+};
+
+/// Fixed-width trailer of a versioned .og file. Section offsets are in bytes
+/// from the start of the serialized members (just after the magic number), so
+/// a reader with the whole file mapped can jump straight to any section.
+struct og_footer_t {
+    uint64_t sections[OG_SECTION_COUNT] = { 0 };
+    uint64_t section_count = OG_SECTION_COUNT;
+    uint64_t marker = OG_FORMAT_MARKER;
+};
+
 class graph_t : public MutablePathDeletableHandleGraph, public SerializableHandleGraph, public RankedHandleGraph {
 
 public:
 
     graph_t(void) {
         // set up initial delimiters
-        path_metadata_h = std::make_unique<lockfree::LockFreeHashTable<uint64_t,
-                                                                       path_metadata_t*>>();
         path_name_h = std::make_unique<lockfree::LockFreeHashTable<std::string,
                                                                    path_metadata_t*>>();
         _edge_count = 0;
@@ -83,6 +126,12 @@ public:
     
     /// Get the sequence of a node, presented in the handle's local forward orientation.
     std::string get_sequence(const handle_t& handle) const;
+
+    /// Get a base of a node in the handle's orientation, without decoding the rest of it
+    char get_base(const handle_t& handle, size_t index) const;
+
+    /// Get a range of a node's sequence in the handle's orientation, decoding only that range
+    std::string get_subsequence(const handle_t& handle, size_t index, size_t size) const;
     
 protected:
     /// Loop over all the handles to next/previous (right/left) nodes. Passes
@@ -246,6 +295,18 @@ public:
     /// Loop over all the steps along a path, from first through last
     void for_each_step_in_path(const path_handle_t& path, const std::function<void(const step_handle_t&)>& iteratee) const;
 
+    /// Loop over the handles visited by a path, from first through last. On a
+    /// frozen graph this scans the path's handle array if it was already built by
+    /// get_path_handles() or build_path_handle_arrays(), and walks the steps otherwise.
+    void for_each_handle_in_path(const path_handle_t& path, const std::function<void(const handle_t&)>& iteratee) const;
+
+    /// Get the handles visited by a path, in order, as a contiguous array.
+    /// Only available on a frozen graph; the arrays are released by thaw().
+    const std::vector<handle_t>& get_path_handles(const path_handle_t& path) const;
+
+    /// Build the handle arrays of all paths of a frozen graph in parallel
+    void build_path_handle_arrays(void);
+
     /// Returns true if the path is circular
     bool get_is_circular(const path_handle_t& path_handle) const;
 
@@ -258,6 +319,18 @@ public:
     /// Create a new node with the given id and sequence, then return the handle.
     handle_t create_handle(const std::string& sequence, const nid_t& id);
 
+    /// Make room for nodes with ids up to max_id, so that they can be added
+    /// from many threads with create_bulk_handle.
+    void prepare_bulk_nodes(const nid_t& max_id);
+
+    /// Create a node in the space made by prepare_bulk_nodes. Safe to call
+    /// concurrently for distinct ids. finish_bulk_nodes must be called once
+    /// all nodes are in, before the graph is otherwise used.
+    handle_t create_bulk_handle(const std::string& sequence, const nid_t& id);
+
+    /// Record the ids left empty by a bulk load as deleted and update the id bounds
+    void finish_bulk_nodes(void);
+
     /// Remove the node belonging to the given handle and all of its edges.
     /// Does not update any stored paths.
     /// Invalidates the destroyed handle.
@@ -278,6 +351,12 @@ public:
         create_edge(edge.first, edge.second);
     }
 
+    /// Create many edges at once on all threads. Each node's new edges are
+    /// grouped so that a single thread writes them without locking, in an
+    /// order that does not depend on the thread count. Existing and repeated
+    /// edges are ignored, and the edge count is updated once at the end.
+    void create_edges(const std::vector<edge_t>& edges);
+
     /// Remove the edge connecting the given handles in the given order and orientations.
     /// Ignores nonexistent edges.
     /// Does not update any stored paths.
@@ -379,6 +458,20 @@ public:
      */
     step_handle_t append_step(const path_handle_t& path, const handle_t& to_append);
 
+    /**
+     * Create and link the steps for a run of handles on a path, without
+     * attaching them to the path. Returns the first and last step. Several
+     * runs of the same path may be created concurrently, then attached in
+     * order with append_path_segment. The run must not be empty.
+     */
+    std::pair<step_handle_t, step_handle_t> create_path_segment(const path_handle_t& path,
+                                                                const std::vector<handle_t>& handles);
+
+    /// Attach a run of length steps made by create_path_segment to the end of the path
+    void append_path_segment(const path_handle_t& path,
+                             const std::pair<step_handle_t, step_handle_t>& segment,
+                             uint64_t length);
+
     /**
      * Insert a visit to a node to the given path between the given steps.
      * Returns a handle to the new step on the path which is appended.
@@ -397,7 +490,8 @@ public:
     /// A helper function to visualize the state of the graph
     void display(void) const;
 
-    /// Convert to GFA (for debugging)
+    /// Convert to GFA. Records are formatted on the threads given by
+    /// set_number_of_threads() and written in rank and path order.
     void to_gfa(std::ostream& out) const;
 
     /// Magic number header for serialization
@@ -409,10 +503,36 @@ public:
     /// Load
     void deserialize_members(std::istream& in);
 
+    /// Load from the given file by memory-mapping it and decoding node records
+    /// directly out of the mapping, which leaves the file in the shared page cache
+    void deserialize_mmap(const std::string& filename);
+
+    /// Load the serialized members from a range of memory, using the offset
+    /// table when the layout is versioned
+    void deserialize_members(const char* begin, const char* end);
+
+    /// Have deserialize_mmap() leave the path steps of each node in the mapped
+    /// file. They are decoded the first time anything reads or changes a step,
+    /// so work that only needs the topology never pays for them.
+    void set_deferred_path_steps(bool defer);
+
+    /// Decode the path steps left in the file by a deferred load, if any
+    void load_path_steps(void) const;
+
     void set_number_of_threads(uint64_t num_threads);
 
     uint64_t get_number_of_threads();
 
+    /// Promise that the graph will not change until thaw() is called. Mutating
+    /// methods throw on a frozen graph, and its accessors skip node locking.
+    void freeze(void);
+
+    /// Allow the graph to be modified again
+    void thaw(void);
+
+    /// Whether the graph is currently frozen
+    bool is_frozen(void) const;
+
     /// copy the other graph into this one
     void copy(const graph_t& other);
 
@@ -426,6 +546,11 @@ public:
     // TODO use it in create_handle and friends
     std::atomic_flag node_lock = ATOMIC_FLAG_INIT;
     std::vector<node_t*> node_v; // not threadsafe
+    /// Where the records in node_v live
+    node_arena_t node_arena;
+    /// Slots reserved for a bulk load, indexed by rank from _bulk_base
+    node_t* _bulk_slab = nullptr;
+    uint64_t _bulk_base = 0;
     node_t& get_node_ref(const handle_t& handle) const;
     const node_t& get_node_cref(const handle_t& handle) const;
     /// Mark deleted nodes here for translating graph ids into internal ranks
@@ -436,6 +561,44 @@ public:
     std::atomic<nid_t> _min_node_id = 0;
     std::atomic<nid_t> _id_increment = 0;
     uint64_t _num_threads = 1;
+    /// Set by freeze() when no further mutation will happen
+    bool _frozen = false;
+
+    /// The handles of a path laid out contiguously, built once while frozen
+    struct path_handle_array_t {
+        std::once_flag built;
+        /// Set once handles is complete
+        std::atomic<bool> ready{false};
+        std::vector<handle_t> handles;
+    };
+    /// Indexed by path handle, allocated by freeze() and released by thaw()
+    std::unique_ptr<path_handle_array_t[]> _path_handle_arrays;
+
+    /// Whether deserialize_mmap() should defer path steps
+    bool _defer_path_steps = false;
+    /// The mapping and step positions kept by a deferred load
+    struct deferred_path_steps_t;
+    mutable std::shared_ptr<deferred_path_steps_t> _deferred_path_steps;
+    mutable std::atomic<bool> _path_steps_deferred{false};
+    mutable std::mutex _deferred_path_steps_lock;
+    inline void ensure_path_steps(void) const {
+        if (_path_steps_deferred.load(std::memory_order_acquire)) load_path_steps();
+    }
+    /// Load from a range of memory, leaving path steps in it when deferred is given
+    void deserialize_members(const char* begin, const char* end, deferred_path_steps_t* deferred);
+
+    /// Node locks are only needed while the graph may still change
+    inline void get_read_lock(node_t& node) const {
+        if (!_frozen) node.get_lock();
+    }
+    inline void clear_read_lock(node_t& node) const {
+        if (!_frozen) node.clear_lock();
+    }
+    inline void assert_mutable(void) const {
+        if (_frozen) {
+            throw std::runtime_error("[odgi::graph_t] error: attempted to modify a frozen graph.");
+        }
+    }
 
     inline void canonicalize_edge(handle_t& left, handle_t& right) const {
         if (number_bool_packing::unpack_bit(left) && number_bool_packing::unpack_bit(right)
@@ -447,13 +610,15 @@ public:
     }
     
     struct path_metadata_t {
-        std::atomic<path_handle_t> handle = as_path_handle(0);
-        std::atomic<uint64_t> length;
+        // the fields read on every walk come first, to share a cache line
         std::atomic<step_handle_t> first;
         std::atomic<step_handle_t> last;
-        std::string name;
+        std::atomic<uint64_t> length;
+        /// as_path_handle(0) in slots with no live path
+        std::atomic<path_handle_t> handle = as_path_handle(0);
         std::atomic<bool> is_circular;
         std::atomic_flag lock = ATOMIC_FLAG_INIT;
+        std::string name;
         inline void get_lock(void) {
             while (lock.test_and_set(std::memory_order_acquire))  // acquire lock
                 ; // spin
@@ -469,10 +634,23 @@ public:
             name = other.name;
             is_circular.store(other.is_circular);
         }
+        /// Return the slot to its empty state
+        void reset(void) {
+            step_handle_t empty;
+            as_integers(empty)[0] = 0;
+            as_integers(empty)[1] = 0;
+            first.store(empty);
+            last.store(empty);
+            length.store(0);
+            handle.store(as_path_handle(0));
+            is_circular.store(false);
+            name.clear();
+        }
     };
 
-    /// maps between path identifier and the start, end, and length of the path
-    std::unique_ptr<lockfree::LockFreeHashTable<uint64_t, path_metadata_t*>> path_metadata_h;
+    /// the start, end, and length of each path, indexed by path handle, which are dense
+    dense_table_t<path_metadata_t> path_metadata_table;
+    /// maps from path name to the path's slot in path_metadata_table
     std::unique_ptr<lockfree::LockFreeHashTable<std::string, path_metadata_t*>> path_name_h;
     path_metadata_t& get_path_metadata(const path_handle_t& path) const;
     const path_metadata_t& path_metadata(const path_handle_t& path) const;
@@ -516,6 +694,22 @@ public:
     /// get the backing node rank for a given node id
     uint64_t get_node_rank(const nid_t& node_id) const;
 
+    /// Decode the node records for node_v[from, to) from a stream, collecting the ids of deleted slots.
+    /// Given the offset of each record in the stream, leave the path steps undecoded and
+    /// note in path_positions where each starts, or 0 for deleted slots.
+    void load_node_range(std::istream& in, uint64_t from, uint64_t to, std::vector<uint64_t>& deleted,
+                         uint64_t version, const uint64_t* record_offsets = nullptr,
+                         uint64_t* path_positions = nullptr);
+
+    /// Hand the bulk slab slots of the given deleted node ids back to the arena for reuse
+    void release_deleted_slots(const std::vector<uint64_t>& deleted);
+
+    /// Decode one path metadata record and register it under the given handle
+    void load_path_metadata(std::istream& in, const path_handle_t& path);
+
+    /// Decode the path metadata records laid out at the given offsets, in parallel
+    void load_path_metadata_range(const char* records, const uint64_t* offsets, uint64_t count);
+
 };
 
 //const static uint64_t path_begin_marker = std::numeric_limits<uint64_t>::max();
@@ -0,0 +1,75 @@
+#include "og_summary.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+namespace odgi {
+
+og_summary_reader_t::og_summary_reader_t(const std::string& filename) {
+    std::error_code error;
+    mmap = mio::make_mmap_source(filename, error);
+    if (error) {
+        throw std::runtime_error("[odgi::og_summary_reader_t] error: could not map \"" + filename + "\": " + error.message());
+    }
+    // skip the magic number written by SerializableHandleGraph::serialize
+    if (mmap.size() < sizeof(uint32_t)) return;
+    begin = mmap.data() + sizeof(uint32_t);
+    end = mmap.data() + mmap.size();
+    // marker, version, and the six fixed header fields that precede the path count
+    const uint64_t header_words = 7;
+    if (end - begin < (int64_t)(header_words*sizeof(uint64_t) + sizeof(og_footer_t))) return;
+    uint64_t marker = 0;
+    std::memcpy(&marker, begin, sizeof(marker));
+    if (marker != OG_FORMAT_MARKER) return;
+    std::memcpy(&_version, begin + sizeof(marker), sizeof(_version));
+    if (_version < 2 || _version > OG_FORMAT_VERSION) return;
+    std::memcpy(&_path_count, begin + (header_words - 1)*sizeof(uint64_t), sizeof(_path_count));
+    // the footer ends with its section count and the marker, preceded by the section offsets
+    uint64_t section_count = 0;
+    std::memcpy(&footer.marker, end - sizeof(uint64_t), sizeof(uint64_t));
+    std::memcpy(&section_count, end - 2*sizeof(uint64_t), sizeof(uint64_t));
+    if (footer.marker != OG_FORMAT_MARKER || (int64_t)((2 + section_count)*sizeof(uint64_t)) > end - begin) {
+        _version = 0;
+        return;
+    }
+    footer.section_count = std::min(section_count, (uint64_t)OG_SECTION_COUNT);
+    std::memcpy(footer.sections, end - (2 + section_count)*sizeof(uint64_t),
+                footer.section_count*sizeof(uint64_t));
+    if (has_summary()) {
+        std::memcpy(&_summary, begin + footer.sections[OG_SUMMARY], sizeof(_summary));
+    }
+}
+
+bool og_summary_reader_t::has_summary(void) const {
+    return _version >= OG_SUMMARY_VERSION && footer.section_count > OG_SUMMARY;
+}
+
+bool og_summary_reader_t::has_path_metadata(void) const {
+    return _version >= 2 && footer.section_count > OG_PATH_METADATA;
+}
+
+void og_summary_reader_t::for_each_path(const std::function<void(const path_handle_t&, const std::string&, uint64_t)>& fn) const {
+    if (!has_path_metadata()) {
+        throw std::runtime_error("[odgi::og_summary_reader_t] error: the graph has no path metadata section.");
+    }
+    const char* offsets = begin + footer.sections[OG_PATH_METADATA];
+    const char* records = offsets + (_path_count + 1)*sizeof(uint64_t);
+    std::string name;
+    for (uint64_t j = 0; j < _path_count; ++j) {
+        uint64_t offset = 0;
+        std::memcpy(&offset, offsets + j*sizeof(uint64_t), sizeof(offset));
+        // length, first and last steps, then the sized name
+        const char* record = records + offset;
+        uint64_t length = 0;
+        std::memcpy(&length, record, sizeof(length));
+        record += sizeof(length) + 2*sizeof(step_handle_t);
+        size_t k = 0;
+        std::memcpy(&k, record, sizeof(k));
+        record += sizeof(k);
+        name.assign(record, k);
+        fn(as_path_handle(j+1), name, length);
+    }
+}
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+/**
+ * \file og_summary.hpp
+ *
+ * Reads the header, summary and path name sections of a graph in ODGI format
+ * without loading its nodes, so that totals and path names of a very large
+ * graph can be listed at the cost of a few pages of the file.
+ *
+ */
+
+#include <cstdint>
+#include <string>
+#include <functional>
+#include <mio/mmap.hpp>
+#include "odgi.hpp"
+
+namespace odgi {
+
+class og_summary_reader_t {
+public:
+    /// Map the given .og file. Throws if it cannot be mapped.
+    og_summary_reader_t(const std::string& filename);
+
+    /// The .og format version of the file, or 0 for the legacy layout
+    uint64_t version(void) const { return _version; }
+    /// Whether the file carries an OG_SUMMARY section
+    bool has_summary(void) const;
+    /// The totals stored with the graph, if has_summary()
+    const og_summary_t& summary(void) const { return _summary; }
+    /// Whether path names can be listed without loading the graph
+    bool has_path_metadata(void) const;
+    /// Call the function with each path handle, name and step count, in handle order
+    void for_each_path(const std::function<void(const path_handle_t&, const std::string&, uint64_t)>& fn) const;
+
+private:
+    mio::mmap_source mmap;
+    /// The file after its magic number
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    uint64_t _version = 0;
+    uint64_t _path_count = 0;
+    og_footer_t footer;
+    og_summary_t _summary;
+};
+
+}
@@ -0,0 +1,249 @@
+#include "packed_sequence.hpp"
+#include "dna.hpp"
+
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include <limits>
+
+namespace odgi {
+
+namespace {
+
+/// The two-bit code of each base, or 4 if it must be kept as an exception
+struct base_codes_t {
+    uint8_t codes[256];
+    base_codes_t(void) {
+        std::memset(codes, 4, sizeof(codes));
+        codes[(uint8_t)'A'] = 0;
+        codes[(uint8_t)'C'] = 1;
+        codes[(uint8_t)'G'] = 2;
+        codes[(uint8_t)'T'] = 3;
+    }
+};
+
+/// The four bases packed into each possible byte
+struct byte_bases_t {
+    char bases[256][4];
+    byte_bases_t(void) {
+        for (uint64_t b = 0; b < 256; ++b) {
+            for (uint64_t i = 0; i < 4; ++i) {
+                bases[b][i] = "ACGT"[(b >> (2 * i)) & 3];
+            }
+        }
+    }
+};
+
+const base_codes_t& base_codes(void) {
+    static const base_codes_t table;
+    return table;
+}
+
+const byte_bases_t& byte_bases(void) {
+    static const byte_bases_t table;
+    return table;
+}
+
+inline char packed_base(const uint8_t* data, uint64_t i) {
+    return "ACGT"[(data[i >> 2] >> ((i & 3) << 1)) & 3];
+}
+
+}
+
+packed_sequence_t::packed_sequence_t(const packed_sequence_t& other) {
+    *this = other;
+}
+
+packed_sequence_t::packed_sequence_t(packed_sequence_t&& other) noexcept {
+    *this = std::move(other);
+}
+
+packed_sequence_t& packed_sequence_t::operator=(const packed_sequence_t& other) {
+    if (this != &other) {
+        allocate(other.length, other.encoding, other.run_count);
+        std::memcpy(data(), other.data(), data_size());
+    }
+    return *this;
+}
+
+packed_sequence_t& packed_sequence_t::operator=(packed_sequence_t&& other) noexcept {
+    if (this != &other) {
+        clear();
+        length = other.length;
+        run_count = other.run_count;
+        encoding = other.encoding;
+        storage = other.storage;
+        // leave the other empty, which is always stored inline
+        other.length = 0;
+        other.run_count = 0;
+        other.encoding = PACKED;
+        other.storage.heap = nullptr;
+    }
+    return *this;
+}
+
+packed_sequence_t::~packed_sequence_t(void) {
+    clear();
+}
+
+void packed_sequence_t::clear(void) {
+    allocate(0, PACKED, 0);
+}
+
+void packed_sequence_t::allocate(uint64_t new_length, encoding_t new_encoding, uint32_t new_run_count) {
+    if (!is_inline()) {
+        delete[] storage.heap;
+    }
+    length = new_length;
+    encoding = new_encoding;
+    run_count = new_run_count;
+    if (is_inline()) {
+        std::memset(storage.bytes, 0, sizeof(storage.bytes));
+    } else {
+        storage.heap = new uint8_t[data_size()]();
+    }
+}
+
+packed_sequence_t::run_t packed_sequence_t::get_run(uint64_t i) const {
+    const uint8_t* r = data() + (length + 3) / 4 + i * RUN_BYTES;
+    run_t run;
+    std::memcpy(&run.offset, r, sizeof(uint64_t));
+    std::memcpy(&run.count, r + sizeof(uint64_t), sizeof(uint64_t));
+    run.base = (char)r[2 * sizeof(uint64_t)];
+    return run;
+}
+
+void packed_sequence_t::set_run(uint64_t i, const run_t& run) {
+    uint8_t* r = data() + (length + 3) / 4 + i * RUN_BYTES;
+    std::memcpy(r, &run.offset, sizeof(uint64_t));
+    std::memcpy(r + sizeof(uint64_t), &run.count, sizeof(uint64_t));
+    r[2 * sizeof(uint64_t)] = (uint8_t)run.base;
+}
+
+void packed_sequence_t::assign(const std::string& seq) {
+    const uint8_t* codes = base_codes().codes;
+    // count the runs of characters that need an exception
+    uint64_t runs = 0;
+    for (uint64_t i = 0; i < seq.size(); ++i) {
+        if (codes[(uint8_t)seq[i]] == 4 && (i == 0 || seq[i] != seq[i-1])) {
+            ++runs;
+        }
+    }
+    uint64_t packed_size = (seq.size() + 3) / 4 + runs * RUN_BYTES;
+    if (packed_size >= seq.size() || runs > std::numeric_limits<uint32_t>::max()) {
+        allocate(seq.size(), RAW, 0);
+        std::memcpy(data(), seq.data(), seq.size());
+        return;
+    }
+    allocate(seq.size(), PACKED, runs);
+    uint8_t* bits = data();
+    uint64_t r = 0;
+    for (uint64_t i = 0; i < seq.size(); ++i) {
+        uint8_t code = codes[(uint8_t)seq[i]];
+        if (code == 4) {
+            if (i == 0 || seq[i] != seq[i-1]) {
+                uint64_t j = i;
+                while (j < seq.size() && seq[j] == seq[i]) ++j;
+                set_run(r++, { i, j - i, seq[i] });
+            }
+            // the bits under an exception are left as zero
+            continue;
+        }
+        bits[i >> 2] |= code << ((i & 3) << 1);
+    }
+}
+
+std::string packed_sequence_t::str(void) const {
+    std::string seq;
+    extract(0, length, seq);
+    return seq;
+}
+
+char packed_sequence_t::at(uint64_t offset) const {
+    assert(offset < length);
+    if (encoding == RAW) {
+        return (char)data()[offset];
+    }
+    for (uint64_t i = 0; i < run_count; ++i) {
+        run_t run = get_run(i);
+        if (run.offset > offset) break;
+        if (offset < run.offset + run.count) return run.base;
+    }
+    return packed_base(data(), offset);
+}
+
+void packed_sequence_t::extract(uint64_t offset, uint64_t count, std::string& out) const {
+    assert(offset + count <= length);
+    const uint8_t* d = data();
+    if (encoding == RAW) {
+        out.append((const char*)d + offset, count);
+        return;
+    }
+    uint64_t start = out.size();
+    out.resize(start + count);
+    char* o = &out[start];
+    uint64_t i = offset;
+    uint64_t end = offset + count;
+    // decode whole bytes at a time once we are aligned to one
+    while (i < end && (i & 3)) {
+        *o++ = packed_base(d, i++);
+    }
+    const byte_bases_t& table = byte_bases();
+    for ( ; i + 4 <= end; i += 4, o += 4) {
+        std::memcpy(o, table.bases[d[i >> 2]], 4);
+    }
+    while (i < end) {
+        *o++ = packed_base(d, i++);
+    }
+    // then lay the exceptions over the range
+    for (uint64_t r = 0; r < run_count; ++r) {
+        run_t run = get_run(r);
+        if (run.offset >= end) break;
+        uint64_t from = std::max(run.offset, offset);
+        uint64_t to = std::min(run.offset + run.count, end);
+        if (from < to) {
+            std::memset(&out[start + from - offset], run.base, to - from);
+        }
+    }
+}
+
+void packed_sequence_t::extract_reverse_complement(uint64_t offset, uint64_t count, std::string& out) const {
+    uint64_t start = out.size();
+    extract(offset, count, out);
+    std::reverse(out.begin() + start, out.end());
+    for (auto it = out.begin() + start; it != out.end(); ++it) {
+        *it = complement[(uint8_t)*it];
+    }
+}
+
+void packed_sequence_t::reverse_complement_in_place(void) {
+    std::string seq;
+    extract_reverse_complement(0, length, seq);
+    assign(seq);
+}
+
+uint64_t packed_sequence_t::serialize(std::ostream& out) const {
+    uint64_t written = 0;
+    out.write((char*)&length, sizeof(length));
+    written += sizeof(length);
+    out.write((char*)&encoding, sizeof(encoding));
+    written += sizeof(encoding);
+    out.write((char*)&run_count, sizeof(run_count));
+    written += sizeof(run_count);
+    out.write((const char*)data(), data_size());
+    written += data_size();
+    return written;
+}
+
+void packed_sequence_t::load(std::istream& in) {
+    uint64_t new_length = 0;
+    encoding_t new_encoding = PACKED;
+    uint32_t new_run_count = 0;
+    in.read((char*)&new_length, sizeof(new_length));
+    in.read((char*)&new_encoding, sizeof(new_encoding));
+    in.read((char*)&new_run_count, sizeof(new_run_count));
+    allocate(new_length, new_encoding, new_run_count);
+    in.read((char*)data(), data_size());
+}
+
+}
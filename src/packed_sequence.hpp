@@ -0,0 +1,82 @@
+#pragma once
+
+/**
+ * \file packed_sequence.hpp
+ *
+ * A node sequence stored at two bits per base, with runs of any other
+ * character (N, IUPAC codes, lowercase) kept as exceptions so that every
+ * sequence reads back exactly. Sequences that would not get smaller this way
+ * are kept as plain bytes, and short ones live inside the object itself.
+ *
+ */
+
+#include <cstdint>
+#include <string>
+#include <iostream>
+
+namespace odgi {
+
+class packed_sequence_t {
+public:
+    packed_sequence_t(void) = default;
+    packed_sequence_t(const packed_sequence_t& other);
+    packed_sequence_t(packed_sequence_t&& other) noexcept;
+    packed_sequence_t& operator=(const packed_sequence_t& other);
+    packed_sequence_t& operator=(packed_sequence_t&& other) noexcept;
+    ~packed_sequence_t(void);
+
+    /// Replace the sequence, choosing the smaller encoding for it
+    void assign(const std::string& seq);
+    /// The whole sequence
+    std::string str(void) const;
+    /// The number of bases
+    inline uint64_t size(void) const { return length; }
+    inline bool empty(void) const { return length == 0; }
+    /// Whether the bases are stored at two bits each
+    inline bool is_packed(void) const { return encoding == PACKED; }
+    /// The base at the given offset
+    char at(uint64_t offset) const;
+    /// Append the bases in [offset, offset+count) to out
+    void extract(uint64_t offset, uint64_t count, std::string& out) const;
+    /// Append the reverse complement of the bases in [offset, offset+count) to out
+    void extract_reverse_complement(uint64_t offset, uint64_t count, std::string& out) const;
+    /// Reverse complement the stored sequence
+    void reverse_complement_in_place(void);
+    void clear(void);
+    uint64_t serialize(std::ostream& out) const;
+    void load(std::istream& in);
+
+private:
+    enum encoding_t : uint8_t { PACKED = 0, RAW = 1 };
+    /// An exception to the packed bases: count copies of base from offset on
+    struct run_t {
+        uint64_t offset;
+        uint64_t count;
+        char base;
+    };
+    /// Runs are stored unaligned after the packed bases
+    static const uint64_t RUN_BYTES = 2 * sizeof(uint64_t) + 1;
+
+    /// Bytes used by the encoded sequence
+    inline uint64_t data_size(void) const {
+        return encoding == PACKED ? (length + 3) / 4 + run_count * RUN_BYTES : length;
+    }
+    /// Small encodings are kept in place of the pointer
+    inline bool is_inline(void) const { return data_size() <= sizeof(storage.bytes); }
+    inline const uint8_t* data(void) const { return is_inline() ? storage.bytes : storage.heap; }
+    inline uint8_t* data(void) { return is_inline() ? storage.bytes : storage.heap; }
+    /// Set up storage for an encoding of the given shape, dropping the old one
+    void allocate(uint64_t new_length, encoding_t new_encoding, uint32_t new_run_count);
+    run_t get_run(uint64_t i) const;
+    void set_run(uint64_t i, const run_t& run);
+
+    uint64_t length = 0;
+    uint32_t run_count = 0;
+    encoding_t encoding = PACKED;
+    union {
+        uint8_t* heap;
+        uint8_t bytes[sizeof(uint8_t*)];
+    } storage = { nullptr };
+};
+
+}
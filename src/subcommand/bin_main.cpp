@@ -97,6 +97,8 @@ int main_bin(int argc, char** argv) {
         }
     }
 
+    graph.freeze();
+
     std::string delim = args::get(path_delim);
     bool agg_delim = args::get(aggregate_delim);
     auto get_path_prefix = [&](const std::string& path_name) -> std::string {
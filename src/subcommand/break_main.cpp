@@ -75,7 +75,7 @@ int main_break(int argc, char** argv) {
             if (infile == "-") {
                 graph.deserialize(std::cin);
             } else {
-				utils::handle_gfa_odgi_input(infile, "break", args::get(progress), num_threads, graph);
+				utils::handle_gfa_odgi_input(infile, "break", args::get(progress), num_threads, graph, true);
             }
         }
     }
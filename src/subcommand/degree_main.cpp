@@ -94,10 +94,12 @@ int main_degree(int argc, char** argv) {
         if (infile == "-") {
             graph.deserialize(std::cin);
         } else {
-			utils::handle_gfa_odgi_input(infile, "degree", args::get(progress), num_threads, graph);
+			utils::handle_gfa_odgi_input(infile, "degree", args::get(progress), num_threads, graph, true);
         }
     }
 
+    graph.freeze();
+
     omp_set_num_threads((int) num_threads);
 
     if (_summarize) {
@@ -138,6 +138,8 @@ namespace odgi {
             }
         }
 
+        graph.freeze();
+
         omp_set_num_threads((int) num_threads);
 
         std::vector<bool> paths_to_consider;
@@ -244,8 +246,8 @@ namespace odgi {
                         end = (uint64_t) std::stoi(vals[2]);
                     } else {
                         // In the BED format, the end is non-inclusive, unlike start
-                        graph.for_each_step_in_path(graph.get_path_handle(path_name), [&](const step_handle_t &s) {
-                            end += graph.get_length(graph.get_handle_of_step(s));
+                        graph.for_each_handle_in_path(graph.get_path_handle(path_name), [&](const handle_t& h) {
+                            end += graph.get_length(h);
                         });
                     }
 
@@ -313,10 +315,9 @@ namespace odgi {
                 ss << graph.get_path_name(path);
                 // for each step
                 uint64_t pos = 0;
-                graph.for_each_step_in_path(
+                graph.for_each_handle_in_path(
                     path,
-                    [&](const step_handle_t& step) {
-                        handle_t handle = graph.get_handle_of_step(step);
+                    [&](const handle_t& handle) {
                         auto depth = graph.get_step_count(handle);
                         auto next_pos = pos + graph.get_length(handle);
                         while (pos++ < next_pos) {
@@ -341,10 +342,9 @@ namespace odgi {
                 ss << graph.get_path_name(path);
                 // for each step
                 uint64_t pos = 0;
-                graph.for_each_step_in_path(
+                graph.for_each_handle_in_path(
                     path,
-                    [&](const step_handle_t& step) {
-                        handle_t handle = graph.get_handle_of_step(step);
+                    [&](const handle_t& handle) {
                         uint64_t depth = 0;
                         graph.for_each_step_on_handle(
                             handle,
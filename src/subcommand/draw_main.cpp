@@ -98,6 +98,8 @@ int main_draw(int argc, char **argv) {
         }
     }
 
+    graph.freeze();
+
     const uint64_t _png_height = png_height ? args::get(png_height) : 1000;
     const double _png_line_width = png_line_width ? args::get(png_line_width) : 0;
     const bool _color_paths = args::get(color_paths);
@@ -73,6 +73,8 @@ int main_flatten(int argc, char** argv) {
         }
     }
 
+    graph.freeze();
+
     // graph linearization with handle to position mapping
     algorithms::linear_index_t linear(graph);
 
@@ -119,8 +121,7 @@ int main_flatten(int argc, char** argv) {
         graph.for_each_path_handle([&](const path_handle_t& p) {
             const std::string path_name = graph.get_path_name(p);
             uint64_t rank = 0;
-            graph.for_each_step_in_path(p, [&](const step_handle_t& s) {
-                const handle_t h = graph.get_handle_of_step(s);
+            graph.for_each_handle_in_path(p, [&](const handle_t& h) {
                 const uint64_t start = linear.position_of_handle(h);
                 const uint64_t end = start + graph.get_length(h);
                 const bool is_rev = graph.get_is_reverse(h);
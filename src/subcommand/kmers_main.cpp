@@ -75,7 +75,7 @@ int main_kmers(int argc, char** argv) {
             if (infile == "-") {
                 graph.deserialize(std::cin);
             } else {
-				utils::handle_gfa_odgi_input(infile, "kmers", args::get(progress), num_threads, graph);
+				utils::handle_gfa_odgi_input(infile, "kmers", args::get(progress), num_threads, graph, true);
             }
         }
     }
@@ -111,9 +111,7 @@ int main_layout0(int argc, char** argv) {
         if (infile == "-") {
             graph.deserialize(std::cin);
         } else {
-            ifstream f(infile.c_str());
-            graph.deserialize(f);
-            f.close();
+            graph.deserialize_mmap(infile);
         }
     }
 
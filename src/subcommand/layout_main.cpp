@@ -128,6 +128,8 @@ int main_layout(int argc, char **argv) {
         }
     }
 
+    graph.freeze();
+
     const uint64_t t_max = !p_sgd_iter_max ? 30 : args::get(p_sgd_iter_max);
     const double eps = !p_sgd_eps ? 0.01 : args::get(p_sgd_eps);
     const double sgd_delta = p_sgd_delta ? args::get(p_sgd_delta) : 0;
@@ -196,10 +198,8 @@ int main_layout(int argc, char **argv) {
 
     // take care of path index
     if (xp_in_file) {
-        std::ifstream in;
-        in.open(args::get(xp_in_file));
-        path_index.load(in);
-        in.close();
+        // mapped, so that jobs sharing an index share its pages
+        path_index.load_mmap(args::get(xp_in_file));
     } else {
         path_index.from_handle_graph(graph, num_threads);
     }
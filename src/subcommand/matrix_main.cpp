@@ -67,6 +67,8 @@ int main_matrix(int argc, char** argv) {
         }
     }
 
+    graph.freeze();
+
     algorithms::write_as_sparse_matrix(std::cout, graph, args::get(weight_by_edge_depth), args::get(weight_by_edge_delta));
 
     return 0;
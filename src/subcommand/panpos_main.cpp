@@ -3,6 +3,8 @@
 #include "algorithms/xp.hpp"
 
 #include <filesystem>
+#include <fstream>
+#include <sstream>
 
 namespace odgi {
 
@@ -23,6 +25,10 @@ namespace odgi {
         args::ValueFlag<std::string> dg_in_file(mandatory_opts, "FILE", "Load the succinct variation graph index in xp format from this *FILE*. The file name usually ends with *.xp*.", {'i', "idx"});
         args::ValueFlag<std::string> path_name(mandatory_opts, "STRING", "The path name of the query.", {'p', "path"});
         args::ValueFlag<uint64_t> nuc_pos(mandatory_opts, "N", "The nucleotide position of the query.", {'n', "nuc-pos"});
+        args::Group batch_opts(parser, "[ Batch Options ]");
+        args::ValueFlag<std::string> batch_file(batch_opts, "FILE", "Translate every query in this tab-separated *FILE* of path names and nucleotide positions, one per line, instead of a single one given by -p and -n. Each query is written back with its pangenome position appended, or *NA* if it is not in the index.", {'b', "batch"});
+        args::Group threading_opts(parser, "[ Threading ]");
+        args::ValueFlag<uint64_t> nthreads(threading_opts, "N", "Number of threads to use for parallel operations.", {'t', "threads"});
         args::Group program_info_opts(parser, "[ Program Information ]");
         args::HelpFlag help(program_info_opts, "help", "Print a help message for odgi panpos.", {'h', "help"});
 
@@ -45,11 +51,15 @@ namespace odgi {
             std::cerr << "[odgi::panpos] error: please enter a file to read the index from via -i=[FILE], --idx=[FILE]." << std::endl;
             exit(1);
         }
-        if (!path_name) {
+        if (batch_file && (path_name || nuc_pos)) {
+            std::cerr << "[odgi::panpos] error: please give either a batch file via -b=[FILE], --batch=[FILE] or a single query via -p and -n, not both." << std::endl;
+            exit(1);
+        }
+        if (!batch_file && !path_name) {
             std::cerr << "[odgi::panpos] error: please enter a valid path name to get the pangenome position from via -p=[STRING], --path=[STRING]." << std::endl;
             exit(1);
         }
-        if (!nuc_pos) {
+        if (!batch_file && !nuc_pos) {
             std::cerr << "[odgi::panpos] error: please enter a valid nucleotide position to get the corresponding pangenome position from -n=[N], --nuc-pos=[N]." << std::endl;
             exit(1);
         }
@@ -59,10 +69,50 @@ namespace odgi {
 			std::cerr << "[odgi::" << "panpos" << "] error: the given file \"" << args::get(dg_in_file) << "\" does not exist. Please specify an existing input file in xp format via -i=[FILE], --idx=[FILE]." << std::endl;
 			return 1;
 		}
-        std::ifstream in;
-        in.open(args::get(dg_in_file));
-        path_index.load(in);
-        in.close();
+        // mapped, so that jobs sharing an index share its pages
+        path_index.load_mmap(args::get(dg_in_file));
+
+        if (batch_file) {
+            const uint64_t num_threads = nthreads ? args::get(nthreads) : 1;
+            std::ifstream in(args::get(batch_file));
+            if (!in) {
+                std::cerr << "[odgi::panpos] error: could not open the batch file " << args::get(batch_file) << "." << std::endl;
+                exit(1);
+            }
+            // every query names a path, so resolve names by hash rather than through the csa
+            path_index.index_path_names(num_threads);
+            std::vector<std::pair<std::string, size_t>> queries;
+            std::string line;
+            uint64_t line_number = 0;
+            while (std::getline(in, line)) {
+                ++line_number;
+                if (line.empty() || line[0] == '#') {
+                    continue;
+                }
+                // path names may hold spaces, so only a tab ends them
+                const size_t tab = line.find('\t');
+                const std::string name = line.substr(0, tab);
+                uint64_t pos = 0;
+                std::istringstream fields(tab == std::string::npos ? "" : line.substr(tab + 1));
+                if (name.empty() || !(fields >> pos) || pos == 0) {
+                    std::cerr << "[odgi::panpos] error: line " << line_number << " of the batch file is not a path name followed by a 1-based nucleotide position." << std::endl;
+                    exit(1);
+                }
+                // we have a 0-based positioning
+                queries.push_back(std::make_pair(name, pos - 1));
+            }
+            std::vector<size_t> pangenome_positions;
+            path_index.get_pangenome_positions(queries, pangenome_positions, num_threads);
+            for (uint64_t i = 0; i < queries.size(); ++i) {
+                std::cout << queries[i].first << "\t" << queries[i].second + 1 << "\t";
+                if (pangenome_positions[i] == XP_NO_PANGENOME_POS) {
+                    std::cout << "NA" << "\n";
+                } else {
+                    std::cout << pangenome_positions[i] + 1 << "\n";
+                }
+            }
+            return 0;
+        }
 
         // we have a 0-based positioning
         const uint64_t nucleotide_pos = args::get(nuc_pos) - 1;
@@ -22,6 +22,10 @@ namespace odgi {
         args::Group mandatory_opts(parser, "[ MANDATORY OPTIONS ]");
         args::ValueFlag<std::string> dg_in_file(mandatory_opts, "FILE", "Load the succinct variation graph in ODGI format from this *FILE*. The file name usually ends with *.og*.", {'i', "idx"});
         args::ValueFlag<std::string> idx_out_file(mandatory_opts, "FILE", "Write the succinct variation graph index to this FILE. A file ending with *.xp* is recommended.", {'o', "out"});
+        args::Group construction_opts(parser, "[ Index Construction ]");
+        args::Flag in_memory(construction_opts, "in-memory", "Sort the node-to-path records in memory. By default this is done when they fit in half of the free memory, and in a temporary file otherwise.", {'m', "in-memory"});
+        args::Flag on_disk(construction_opts, "on-disk", "Always sort the node-to-path records in a temporary file.", {'d', "on-disk"});
+        args::ValueFlag<std::string> update_file(construction_opts, "FILE", "Update the path index in this *FILE*, built for the same nodes, by adding the paths of the graph it does not have yet instead of indexing every path again.", {'u', "update"});
         args::Group threading_opts(parser, "[ Threading ]");
         args::ValueFlag<std::uint64_t> nthreads(threading_opts, "N", "Number of threads to use for parallel operations.", {'t', "threads"});
 		args::Group processing_info_opts(parser, "[ Processing Information ]");
@@ -56,6 +60,12 @@ namespace odgi {
             return 1;
         }
 
+        if (in_memory && on_disk) {
+            std::cerr << "[odgi::pathindex] error: please specify only one of -m, --in-memory and -d, --on-disk."
+                      << std::endl;
+            return 1;
+        }
+
 		const uint64_t num_threads = nthreads ? args::get(nthreads) : 1;
 
 		// read in the graph
@@ -73,8 +83,34 @@ namespace odgi {
             }
         }
 
+        graph.freeze();
+
         XP path_index;
-        path_index.from_handle_graph(graph, num_threads);
+        if (update_file) {
+            // read rather than map, so that the index can be written back to the same file
+            std::ifstream in(args::get(update_file));
+            path_index.load(in);
+            in.close();
+            std::vector<path_handle_t> new_paths;
+            graph.for_each_path_handle([&](const path_handle_t &path) {
+                if (!path_index.has_path(graph.get_path_name(path))) {
+                    new_paths.push_back(path);
+                }
+            });
+            try {
+                path_index.add_paths(graph, new_paths, num_threads);
+            } catch (const std::runtime_error& e) {
+                std::cerr << "[odgi::pathindex] error: could not update " << args::get(update_file) << ": " << e.what() << std::endl;
+                return 1;
+            }
+            if (progress) {
+                std::cout << "Added " << new_paths.size() << " path(s) to the index." << std::endl;
+            }
+        } else {
+            const node_path_sort_t node_path_sort = in_memory ? node_path_sort_t::in_memory
+                : (on_disk ? node_path_sort_t::on_disk : node_path_sort_t::automatic);
+            path_index.from_handle_graph(graph, num_threads, node_path_sort);
+        }
 		if (progress) {
 			std::cout << "Indexed " << path_index.path_count << " path(s)." << std::endl;
 		}
@@ -5,6 +5,7 @@
 #include "position.hpp"
 #include <omp.h>
 #include "utils.hpp"
+#include "og_summary.hpp"
 
 namespace odgi {
 
@@ -73,6 +74,23 @@ int main_paths(int argc, char** argv) {
 	const uint64_t num_threads = args::get(threads) ? args::get(threads) : 1;
     omp_set_num_threads(num_threads);
 
+    {
+        // path names can be listed from the path metadata of an .og file without loading its nodes
+        const std::string& infile = args::get(dg_in_file);
+        bool names_only = args::get(list_names) && !overlaps_file && !args::get(haplo_matrix)
+            && !args::get(distance_matrix) && !args::get(write_fasta);
+        if (names_only && infile != "-" && !utils::ends_with(infile, "gfa") && !utils::ends_with(infile, "gfa.gz")
+            && !utils::ends_with(infile, "gfa.bgz") && std::filesystem::exists(infile)) {
+            og_summary_reader_t reader(infile);
+            if (reader.has_path_metadata()) {
+                reader.for_each_path([&](const path_handle_t& p, const std::string& name, uint64_t step_count) {
+                        std::cout << name << std::endl;
+                    });
+                return 0;
+            }
+        }
+    }
+
 	graph_t graph;
     assert(argc > 0);
     std::string infile = args::get(dg_in_file);
@@ -84,6 +102,8 @@ int main_paths(int argc, char** argv) {
         }
     }
 
+    graph.freeze();
+
     //args::Flag list_names(parser, "list-names", "list the paths in the graph", {'L', "list-paths"});
     if (args::get(list_names)) {
         graph.for_each_path_handle([&](const path_handle_t& p) {
@@ -95,9 +115,9 @@ int main_paths(int argc, char** argv) {
         graph.for_each_path_handle(
             [&](const path_handle_t& p) {
                 std::cout << ">" << graph.get_path_name(p) << std::endl;
-                graph.for_each_step_in_path(
-                    p, [&](const step_handle_t& s) {
-                           std::cout << graph.get_sequence(graph.get_handle_of_step(s));
+                graph.for_each_handle_in_path(
+                    p, [&](const handle_t& h) {
+                           std::cout << graph.get_sequence(h);
                        });
                 std::cout << std::endl;
             });
@@ -131,10 +151,9 @@ int main_paths(int argc, char** argv) {
                 uint64_t path_length = 0;
                 uint64_t path_step_count = 0;
                 std::vector<bool> row(graph.get_node_count());
-                graph.for_each_step_in_path(
+                graph.for_each_handle_in_path(
                     p,
-                    [&](const step_handle_t& s) {
-                        const handle_t& h = graph.get_handle_of_step(s);
+                    [&](const handle_t& h) {
                         path_length += graph.get_length(h);
                         ++path_step_count;
                         row[graph.get_id(h)-1] = 1;
@@ -212,10 +231,10 @@ int main_paths(int argc, char** argv) {
         for (uint64_t i = 0; i < path_max; ++i) {
             path_handle_t p = as_path_handle(i + 1);
             uint64_t path_length = 0;
-            graph.for_each_step_in_path(
+            graph.for_each_handle_in_path(
                 p,
-                [&](const step_handle_t& s) {
-                    path_length += graph.get_length(graph.get_handle_of_step(s));
+                [&](const handle_t& h) {
+                    path_length += graph.get_length(h);
                 });
 #pragma omp critical (bp_count)
             bp_count[get_path_id(p)] += path_length;
@@ -304,8 +323,7 @@ int main_paths(int argc, char** argv) {
             // walk the path, adding each position to the decomposition
             path_handle_t path = graph.get_path_handle(path_name);
             uint64_t pos = 0;
-            graph.for_each_step_in_path(path, [&](const step_handle_t& occ) {
-                    handle_t h = graph.get_handle_of_step(occ);
+            graph.for_each_handle_in_path(path, [&](const handle_t& h) {
                     nid_t id = graph.get_id(h);
                     uint64_t len = graph.get_length(h);
                     for (uint64_t i = 0; i < len; ++i) {
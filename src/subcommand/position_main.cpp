@@ -4,6 +4,7 @@
 #include "args.hxx"
 #include "split.hpp"
 #include "algorithms/bfs.hpp"
+#include "csr_graph.hpp"
 #include <omp.h>
 #include "utils.hpp"
 
@@ -453,10 +454,24 @@ int main_position(int argc, char** argv) {
             return lifts.size() > 0;
         };
 
+    // with many queries, walk the neighbourhoods over flat adjacency snapshots
+    // rather than decoding the edges of each node on every visit
+    std::unique_ptr<CSRHandleGraph> target_adjacency;
+    std::unique_ptr<CSRHandleGraph> source_adjacency;
+    if (graph_positions.size() + path_positions.size() + 2 * path_ranges.size() >= 1024) {
+        target_adjacency = std::make_unique<CSRHandleGraph>(&target_graph, num_threads);
+        if (lifting) {
+            source_adjacency = std::make_unique<CSRHandleGraph>(&source_graph, num_threads);
+        }
+    }
+
     auto get_position =
-        [&search_radius,&get_offset_in_path](const odgi::graph_t& graph,
-                                             const hash_set<uint64_t>& path_set,
-                                             const pos_t& pos, lift_result_t& lift) {
+        [&search_radius,&get_offset_in_path,&target_graph,&target_adjacency,&source_adjacency]
+        (const odgi::graph_t& graph,
+         const hash_set<uint64_t>& path_set,
+         const pos_t& pos, lift_result_t& lift) {
+            const auto& snapshot = (&graph == &target_graph ? target_adjacency : source_adjacency);
+            const HandleGraph& adjacency = snapshot ? *snapshot : static_cast<const HandleGraph&>(graph);
             // unpacking our args
             int64_t& path_offset = lift.path_offset;
             step_handle_t& ref_hit = lift.ref_hit;
@@ -470,7 +485,7 @@ int main_position(int argc, char** argv) {
             for (auto try_bidirectional : { false, true }) {
                 if (try_bidirectional) used_bidirectional = true;
                 odgi::algorithms::bfs(
-                    graph,
+                    adjacency,
                     [&](const handle_t& h, const uint64_t& r, const uint64_t& l, const uint64_t& d) {
                         seen.insert(as_integer(h));
                         bool got_hit = false;
@@ -8,6 +8,7 @@
 #include "algorithms/cut_tips.hpp"
 #include "algorithms/remove_isolated.hpp"
 #include "algorithms/expand_context.hpp"
+#include "csr_graph.hpp"
 #include "utils.hpp"
 
 namespace odgi {
@@ -94,7 +95,7 @@ int main_prune(int argc, char** argv) {
             if (infile == "-") {
                 graph.deserialize(std::cin);
             } else {
-				utils::handle_gfa_odgi_input(infile, "prune", args::get(progress), n_threads, graph);
+				utils::handle_gfa_odgi_input(infile, "prune", args::get(progress), n_threads, graph, true);
             }
         }
     }
@@ -153,12 +154,14 @@ int main_prune(int argc, char** argv) {
             graph_t source;
             source.copy(graph);
             do_destroy();
-            algorithms::expand_context(&source, &graph, args::get(expand_steps), true);
+            CSRHandleGraph adjacency(&source, n_threads);
+            algorithms::expand_context(&adjacency, &graph, args::get(expand_steps), true);
         } else if (args::get(expand_length)) {
             graph_t source;
             source.copy(graph);
             do_destroy();
-            algorithms::expand_context(&source, &graph, args::get(expand_length), false);
+            CSRHandleGraph adjacency(&source, n_threads);
+            algorithms::expand_context(&adjacency, &graph, args::get(expand_length), false);
         } else if (args::get(expand_path_length)) {
             graph_t source;
             source.copy(graph);
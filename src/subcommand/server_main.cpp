@@ -1,8 +1,16 @@
 #include "subcommand.hpp"
 #include "args.hxx"
 #include "algorithms/xp.hpp"
+#include "algorithms/subgraph/extract.hpp"
+#include "odgi.hpp"
+#include "utils.hpp"
+#include "lru_cache.hpp"
 #include <httplib.h>
 #include <filesystem>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
 
 namespace odgi {
 
@@ -10,6 +18,238 @@ namespace odgi {
     using namespace xp;
     using namespace httplib;
 
+    namespace {
+
+        typedef std::vector<std::pair<std::string, size_t>> position_queries_t;
+
+        /// Read a non-negative number, which must fit in 64 bits
+        bool parse_count(const std::string& text, size_t& count) {
+            if (text.empty() || text.size() > 20) {
+                return false;
+            }
+            for (auto c : text) {
+                if (!std::isdigit((unsigned char)c)) {
+                    return false;
+                }
+            }
+            try {
+                count = std::stoull(text);
+            } catch (const std::out_of_range&) {
+                return false;
+            }
+            return true;
+        }
+
+        /// Read a 1-based position, which must fit in 64 bits
+        bool parse_position(const std::string& text, size_t& pos) {
+            return parse_count(text, pos) && pos > 0;
+        }
+
+        /// Read queries given as tab-separated path names and 1-based positions, one per line
+        bool parse_tsv_queries(const std::string& body, position_queries_t& queries, std::string& error) {
+            std::istringstream in(body);
+            std::string line;
+            uint64_t line_number = 0;
+            while (std::getline(in, line)) {
+                ++line_number;
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                if (line.empty() || line[0] == '#') {
+                    continue;
+                }
+                const size_t tab = line.find('\t');
+                size_t pos = 0;
+                if (tab == 0 || tab == std::string::npos || !parse_position(line.substr(tab + 1), pos)) {
+                    error = "line " + std::to_string(line_number) + " is not a path name and a 1-based position separated by a tab";
+                    return false;
+                }
+                queries.push_back(std::make_pair(line.substr(0, tab), pos - 1));
+            }
+            return true;
+        }
+
+        /// Read queries given as a JSON array of {"path": "name", "pos": N} objects with 1-based positions
+        bool parse_json_queries(const std::string& body, position_queries_t& queries, std::string& error) {
+            size_t i = 0;
+            auto skip_space = [&]() {
+                while (i < body.size() && std::isspace((unsigned char)body[i])) ++i;
+            };
+            auto expect = [&](char c) {
+                skip_space();
+                if (i < body.size() && body[i] == c) {
+                    ++i;
+                    return true;
+                }
+                error = std::string("expected '") + c + "' at offset " + std::to_string(i);
+                return false;
+            };
+            auto peek = [&]() {
+                skip_space();
+                return i < body.size() ? body[i] : '\0';
+            };
+            auto read_string = [&](std::string& out) {
+                if (!expect('"')) return false;
+                out.clear();
+                while (i < body.size() && body[i] != '"') {
+                    if (body[i] == '\\' && i + 1 < body.size()) {
+                        ++i;
+                        switch (body[i]) {
+                        case 'n': out.push_back('\n'); break;
+                        case 't': out.push_back('\t'); break;
+                        case 'r': out.push_back('\r'); break;
+                        case 'b': out.push_back('\b'); break;
+                        case 'f': out.push_back('\f'); break;
+                        case 'u':
+                            error = "unicode escapes are not supported in path names, at offset " + std::to_string(i);
+                            return false;
+                        default: out.push_back(body[i]); break;
+                        }
+                    } else {
+                        out.push_back(body[i]);
+                    }
+                    ++i;
+                }
+                return expect('"');
+            };
+            auto read_number = [&](size_t& out) {
+                skip_space();
+                size_t start = i;
+                while (i < body.size() && std::isdigit((unsigned char)body[i])) ++i;
+                if (!parse_position(body.substr(start, i - start), out)) {
+                    error = "expected a 1-based position at offset " + std::to_string(start);
+                    return false;
+                }
+                return true;
+            };
+            if (!expect('[')) return false;
+            if (peek() == ']') {
+                ++i;
+            } else {
+                while (true) {
+                    if (!expect('{')) return false;
+                    std::string name;
+                    size_t pos = 0;
+                    bool has_name = false, has_pos = false;
+                    while (true) {
+                        std::string key;
+                        if (!read_string(key) || !expect(':')) return false;
+                        if (key == "path") {
+                            if (!read_string(name)) return false;
+                            has_name = true;
+                        } else if (key == "pos") {
+                            if (!read_number(pos)) return false;
+                            has_pos = true;
+                        } else {
+                            error = "unknown key \"" + key + "\" at offset " + std::to_string(i);
+                            return false;
+                        }
+                        if (peek() == ',') {
+                            ++i;
+                        } else {
+                            break;
+                        }
+                    }
+                    if (!expect('}')) return false;
+                    if (!has_name || !has_pos) {
+                        error = "query " + std::to_string(queries.size() + 1) + " needs both a \"path\" and a \"pos\"";
+                        return false;
+                    }
+                    queries.push_back(std::make_pair(name, pos - 1));
+                    if (peek() == ',') {
+                        ++i;
+                    } else {
+                        break;
+                    }
+                }
+                if (!expect(']')) return false;
+            }
+            if (peek() != '\0') {
+                error = "unexpected data after the queries at offset " + std::to_string(i);
+                return false;
+            }
+            return true;
+        }
+
+        /// Read the path from the query parameters. Returns the HTTP status to answer with,
+        /// which is 200 if the path is in the index.
+        int parse_path(const Request& req, const XP& path_index, path_handle_t& path, std::string& error) {
+            if (!req.has_param("path")) {
+                error = "please give a path name via path=NAME";
+                return 400;
+            }
+            const std::string path_name = req.get_param_value("path");
+            if (!path_index.has_path(path_name)) {
+                error = "path " + path_name + " is not in the index";
+                return 404;
+            }
+            path = path_index.get_path_handle(path_name);
+            return 200;
+        }
+
+        /// Read the path and the optional 1-based, inclusive start and end of a path range
+        /// from the query parameters, as 0-based positions. Returns the HTTP status to answer
+        /// with, which is 200 if the range is in the index.
+        int parse_path_range(const Request& req, const XP& path_index,
+                             path_handle_t& path, size_t& start, size_t& end, std::string& error) {
+            const int status = parse_path(req, path_index, path, error);
+            if (status != 200) {
+                return status;
+            }
+            const std::string path_name = path_index.get_path_name(path);
+            const size_t length = path_index.get_path_length(path);
+            start = 1;
+            end = length;
+            if (req.has_param("start") && !parse_position(req.get_param_value("start"), start)) {
+                error = "invalid 1-based start position: " + req.get_param_value("start");
+                return 400;
+            }
+            if (req.has_param("end") && !parse_position(req.get_param_value("end"), end)) {
+                error = "invalid 1-based end position: " + req.get_param_value("end");
+                return 400;
+            }
+            if (start > end || end > length) {
+                error = "the range " + std::to_string(start) + "-" + std::to_string(end)
+                    + " is not within path " + path_name + " of length " + std::to_string(length);
+                return 404;
+            }
+            --start;
+            --end;
+            return 200;
+        }
+
+        /// Quote a string for JSON
+        std::string json_string(const std::string& text) {
+            std::string out = "\"";
+            for (auto c : text) {
+                switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\t': out += "\\t"; break;
+                case '\r': out += "\\r"; break;
+                default:
+                    if ((unsigned char)c < 0x20) {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+                        out += escaped;
+                    } else {
+                        out.push_back(c);
+                    }
+                }
+            }
+            out += "\"";
+            return out;
+        }
+
+        void set_cors_headers(Response& res) {
+            res.set_header("Access-Control-Allow-Origin", "*");
+            res.set_header("Access-Control-Expose-Headers", "text/plain");
+            res.set_header("Access-Control-Allow-Methods", "GET, POST, DELETE, PUT");
+        }
+
+    }
+
     int main_server(int argc, char** argv) {
 
         for (uint64_t i = 1; i < argc-1; ++i) {
@@ -25,6 +265,12 @@ namespace odgi {
         args::ValueFlag<std::string> port(mandatory_opts, "N", "Run the server under this port.", {'p', "port"});
         args::Group http_opts(parser, "[ HTTP Options ]");
         args::ValueFlag<std::string> ip_address(http_opts, "IP", "Run the server under this IP address. If not specified, *IP* will be *localhost*.", {'a', "ip"});
+        args::Flag silent(http_opts, "silent", "Do not log each request to stdout.", {'s', "silent"});
+        args::Group graph_opts(parser, "[ Graph Queries ]");
+        args::ValueFlag<std::string> og_in_file(graph_opts, "FILE", "Keep the graph the index was built from in memory, so that subgraphs of path ranges (*/extract*), node and path range depths (*/depth*) and the nodes under path positions (*/lift*) can be queried. It is read from this *FILE*, in ODGI or GFAv1 format.", {'g', "graph"});
+        args::ValueFlag<uint64_t> cache_memory(graph_opts, "N", "Keep the answers to up to *N* megabytes of repeated */extract* and */depth* path range queries in memory, dropping the least recently used ones first. 0 turns the cache off [default: 256].", {'m', "cache-memory"});
+        args::Group threading_opts(parser, "[ Threading ]");
+        args::ValueFlag<uint64_t> nthreads(threading_opts, "N", "Number of worker threads answering requests.", {'t', "threads"});
         args::Group program_information(parser, "[ Program Information ]");
         args::HelpFlag help(program_information, "help", "Print a help message for odgi server.", {'h', "help"});
 
@@ -53,15 +299,35 @@ namespace odgi {
             exit(1);
         }
 
+        const uint64_t num_threads = nthreads ? std::max(args::get(nthreads), (uint64_t)1) : 1;
+
         XP path_index;
 		if (!std::filesystem::exists(args::get(dg_in_file))) {
 			std::cerr << "[odgi::" << "panpos" << "] error: the given file \"" << args::get(dg_in_file) << "\" does not exist. Please specify an existing input file in xp format via -i=[FILE], --idx=[FILE]." << std::endl;
 			return 1;
 		}
-        std::ifstream in;
-        in.open(args::get(dg_in_file));
-        path_index.load(in);
-        in.close();
+        // mapped, so that jobs sharing an index share its pages
+        path_index.load_mmap(args::get(dg_in_file));
+        // every request names a path, so resolve names by hash rather than through the csa
+        path_index.index_path_names();
+
+        graph_t graph;
+        if (og_in_file) {
+            utils::handle_gfa_odgi_input(args::get(og_in_file), "server", false, num_threads, graph);
+            graph.freeze();
+            if (graph.get_node_count() + 1 != path_index.get_pos_map_iv().size()) {
+                std::cerr << "[odgi::server] error: the graph has " << graph.get_node_count() << " nodes, but the index was built from a graph with "
+                          << path_index.get_pos_map_iv().size() - 1 << " nodes. Please give the graph the index was built from." << std::endl;
+                return 1;
+            }
+            // subgraphs find the paths through their nodes without walking them
+            try {
+                path_index.index_node_steps(graph, num_threads);
+            } catch (const std::runtime_error& e) {
+                std::cerr << "[odgi::server] error: " << e.what() << std::endl;
+                return 1;
+            }
+        }
 
         /*
         const char* pattern = R"(/(\d+)/(\w+))";
@@ -87,38 +353,238 @@ namespace odgi {
         */
 
         Server svr;
+        svr.new_task_queue = [num_threads] { return new ThreadPool(num_threads); };
+        const bool log_requests = !args::get(silent);
 
-        svr.Get("/hi", [](const Request& req, Response& res) {
-            res.set_header("Access-Control-Allow-Origin", "*");
-            res.set_header("Access-Control-Expose-Headers", "text/plain");
-            res.set_header("Access-Control-Allow-Methods", "GET, POST, DELETE, PUT");
+        svr.Get("/hi", [&](const Request& req, Response& res) {
+            set_cors_headers(res);
             res.set_content("Hello World!", "text/plain");
-            std::cout << "GOT REQUEST : HELLO WORLD!" << std::endl;
+            if (log_requests) {
+                std::cout << "GOT REQUEST : HELLO WORLD!" << std::endl;
+            }
         });
 
         svr.Get(R"(/(\w*.*)/(\d+))", [&](const Request& req, Response& res) {
-            /*
-            for (size_t i = 0; i < req.matches.size(); i++) {
-                std::cout << req.matches[i] << std::endl;
-            }
-             */
-            auto path_name = req.matches[1];
-            auto nuc_pos_1 = req.matches[2];
-            std::cout << "GOT REQUEST : path name: " << path_name << "; 1-based nucleotide position: " << nuc_pos_1 << std::endl;
-            size_t nuc_pos_0 = std::stoi(nuc_pos_1) - 1;
+            const std::string path_name = req.matches[1];
+            const std::string nuc_pos_1 = req.matches[2];
+            set_cors_headers(res);
+            size_t nuc_pos = 0;
+            if (!parse_position(nuc_pos_1, nuc_pos)) {
+                res.status = 400;
+                res.set_content("invalid 1-based nucleotide position: " + nuc_pos_1, "text/plain");
+                return;
+            }
+            const size_t nuc_pos_0 = nuc_pos - 1;
             size_t pan_pos = 0;
-            if (path_index.has_path(path_name)) {
-                if (path_index.has_position(path_name, nuc_pos_0)) {
-                    pan_pos = path_index.get_pangenome_pos(path_name, nuc_pos_0) + 1;
-                }
+            if (path_index.has_position(path_name, nuc_pos_0)) {
+                pan_pos = path_index.get_pangenome_pos(path_name, nuc_pos_0) + 1;
+            }
+            if (log_requests) {
+                std::ostringstream log;
+                log << "GOT REQUEST : path name: " << path_name << "; 1-based nucleotide position: " << nuc_pos_1 << "\n"
+                    << "SEND RESPONSE: pangenome position: " << pan_pos << "\n";
+                std::cout << log.str() << std::flush;
             }
-            std::cout << "SEND RESPONSE: pangenome position: " << pan_pos << std::endl;
-            res.set_header("Access-Control-Allow-Origin", "*");
-            res.set_header("Access-Control-Expose-Headers", "text/plain");
-            res.set_header("Access-Control-Allow-Methods", "GET, POST, DELETE, PUT");
             res.set_content(std::to_string(pan_pos), "text/plain");
         });
 
+        // many queries at once, as TSV lines of path name and position or as a JSON array of
+        // {"path": ..., "pos": ...} objects; each query is answered by a TSV line with its
+        // pangenome position appended, or NA if it is not in the index
+        svr.Post("/batch", [&](const Request& req, Response& res) {
+            set_cors_headers(res);
+            position_queries_t queries;
+            std::string error;
+            const size_t first = req.body.find_first_not_of(" \t\r\n");
+            const bool is_json = req.get_header_value("Content-Type").find("json") != std::string::npos
+                || (first != std::string::npos && req.body[first] == '[');
+            if (!(is_json ? parse_json_queries(req.body, queries, error) : parse_tsv_queries(req.body, queries, error))) {
+                res.status = 400;
+                res.set_content(error + "\n", "text/plain");
+                return;
+            }
+            // the worker pool already answers requests in parallel
+            std::vector<size_t> pangenome_positions;
+            path_index.get_pangenome_positions(queries, pangenome_positions, 1);
+            std::string out;
+            out.reserve(queries.size() * 32);
+            for (size_t i = 0; i < queries.size(); ++i) {
+                out += queries[i].first;
+                out += '\t';
+                out += std::to_string(queries[i].second + 1);
+                out += '\t';
+                out += pangenome_positions[i] == XP_NO_PANGENOME_POS ? "NA" : std::to_string(pangenome_positions[i] + 1);
+                out += '\n';
+            }
+            if (log_requests) {
+                std::ostringstream log;
+                log << "GOT REQUEST : batch of " << queries.size() << " position(s)" << "\n";
+                std::cout << log.str() << std::flush;
+            }
+            res.set_content(out, "text/tab-separated-values");
+        });
+
+        // answers to path range queries by their normalized query
+        lru_cache_t cache((cache_memory ? args::get(cache_memory) : 256) * 1024 * 1024);
+
+        if (og_in_file) {
+            // the subgraph of a path range, with context=N steps around it, in GFA
+            svr.Get("/extract", [&](const Request& req, Response& res) {
+                set_cors_headers(res);
+                path_handle_t path;
+                size_t start = 0, end = 0, context = 0;
+                std::string error;
+                const int status = parse_path_range(req, path_index, path, start, end, error);
+                if (status != 200) {
+                    res.status = status;
+                    res.set_content(error + "\n", "text/plain");
+                    return;
+                }
+                if (req.has_param("context") && !parse_count(req.get_param_value("context"), context)) {
+                    res.status = 400;
+                    res.set_content("invalid number of context steps: " + req.get_param_value("context") + "\n", "text/plain");
+                    return;
+                }
+                const std::string key = "extract\t" + std::to_string(as_integer(path)) + "\t" + std::to_string(start)
+                    + "\t" + std::to_string(end) + "\t" + std::to_string(context);
+                lru_cache_t::value_t gfa = cache.get(key);
+                const bool cached = gfa != nullptr;
+                if (!cached) {
+                    graph_t subgraph;
+                    algorithms::extract_indexed_path_range(graph, path_index, path, start, end, subgraph);
+                    if (context > 0) {
+                        algorithms::expand_subgraph_by_steps(graph, subgraph, context, false);
+                    }
+                    algorithms::add_connecting_edges_to_subgraph(graph, subgraph);
+                    algorithms::add_indexed_subpaths_to_subgraph(graph, path_index, subgraph);
+                    std::stringstream out;
+                    subgraph.to_gfa(out);
+                    gfa = std::make_shared<const std::string>(out.str());
+                    cache.put(key, gfa);
+                }
+                if (log_requests) {
+                    std::ostringstream log;
+                    log << "GOT REQUEST : extract " << path_index.get_path_name(path) << ":" << start + 1 << "-" << end + 1
+                        << " with " << context << " context step(s)" << "\n"
+                        << "SEND RESPONSE: " << gfa->size() << " bytes of GFA" << (cached ? " from the cache" : "") << "\n";
+                    std::cout << log.str() << std::flush;
+                }
+                res.set_content(*gfa, "text/plain");
+            });
+
+            // the depth of a node=ID, or the mean depth of a path range with the depth of each step in it, in JSON
+            svr.Get("/depth", [&](const Request& req, Response& res) {
+                set_cors_headers(res);
+                std::ostringstream query;
+                lru_cache_t::value_t json;
+                bool cached = false;
+                if (req.has_param("node")) {
+                    size_t id = 0;
+                    if (!parse_position(req.get_param_value("node"), id)) {
+                        res.status = 400;
+                        res.set_content("invalid node id: " + req.get_param_value("node") + "\n", "text/plain");
+                        return;
+                    }
+                    if (!graph.has_node(id)) {
+                        res.status = 404;
+                        res.set_content("node " + std::to_string(id) + " is not in the graph\n", "text/plain");
+                        return;
+                    }
+                    json = std::make_shared<const std::string>("{\"node\":" + std::to_string(id) + ",\"depth\":"
+                                                               + std::to_string(graph.get_step_count(graph.get_handle(id))) + "}");
+                    query << "node " << id;
+                } else {
+                    path_handle_t path;
+                    size_t start = 0, end = 0;
+                    std::string error;
+                    const int status = parse_path_range(req, path_index, path, start, end, error);
+                    if (status != 200) {
+                        res.status = status;
+                        res.set_content(error + "\n", "text/plain");
+                        return;
+                    }
+                    const std::string key = "depth\t" + std::to_string(as_integer(path)) + "\t" + std::to_string(start)
+                        + "\t" + std::to_string(end);
+                    json = cache.get(key);
+                    cached = json != nullptr;
+                    if (!cached) {
+                        // the depth of each step, and their mean weighted by the bases each covers
+                        std::vector<std::pair<nid_t, uint64_t>> step_depths;
+                        const double mean_depth = algorithms::indexed_path_range_depth(graph, path_index, path, start, end, step_depths);
+                        std::ostringstream nodes;
+                        for (size_t i = 0; i < step_depths.size(); ++i) {
+                            nodes << (i ? "," : "")
+                                  << "{\"node\":" << step_depths[i].first << ",\"depth\":" << step_depths[i].second << "}";
+                        }
+                        std::ostringstream out;
+                        out << "{\"path\":" << json_string(path_index.get_path_name(path))
+                            << ",\"start\":" << start + 1 << ",\"end\":" << end + 1
+                            << ",\"mean_depth\":" << mean_depth
+                            << ",\"nodes\":[" << nodes.str() << "]}";
+                        json = std::make_shared<const std::string>(out.str());
+                        cache.put(key, json);
+                    }
+                    query << path_index.get_path_name(path) << ":" << start + 1 << "-" << end + 1;
+                }
+                if (log_requests) {
+                    std::ostringstream log;
+                    log << "GOT REQUEST : depth of " << query.str() << (cached ? ", from the cache" : "") << "\n";
+                    std::cout << log.str() << std::flush;
+                }
+                res.set_content(*json, "application/json");
+            });
+
+            // the cache's use and hit and miss counters, in JSON
+            svr.Get("/cache", [&](const Request& req, Response& res) {
+                set_cors_headers(res);
+                std::ostringstream out;
+                out << "{\"capacity\":" << cache.capacity() << ",\"bytes\":" << cache.bytes()
+                    << ",\"entries\":" << cache.size() << ",\"hits\":" << cache.hits()
+                    << ",\"misses\":" << cache.misses() << ",\"evictions\":" << cache.evictions() << "}";
+                res.set_content(out.str(), "application/json");
+            });
+
+            // the node, its orientation and the offset on its forward strand under the 1-based pos=N of a path, in JSON
+            svr.Get("/lift", [&](const Request& req, Response& res) {
+                set_cors_headers(res);
+                path_handle_t path;
+                size_t pos = 0;
+                std::string error;
+                int status = parse_path(req, path_index, path, error);
+                if (status == 200 && !parse_position(req.get_param_value("pos"), pos)) {
+                    error = "invalid 1-based nucleotide position: " + req.get_param_value("pos");
+                    status = 400;
+                } else if (status == 200 && pos > path_index.get_path_length(path)) {
+                    error = "position " + std::to_string(pos) + " is not within path " + req.get_param_value("path");
+                    status = 404;
+                }
+                if (status != 200) {
+                    res.status = status;
+                    res.set_content(error + "\n", "text/plain");
+                    return;
+                }
+                const size_t nuc_pos_0 = pos - 1;
+                const step_handle_t step = path_index.get_step_at_position(path, nuc_pos_0);
+                const handle_t h = path_index.get_handle_of_step(step);
+                size_t node_offset = nuc_pos_0 - path_index.get_position_of_step(step);
+                if (graph.get_is_reverse(h)) {
+                    node_offset = graph.get_length(h) - node_offset - 1;
+                }
+                const std::string path_name = path_index.get_path_name(path);
+                std::ostringstream out;
+                out << "{\"path\":" << json_string(path_name) << ",\"pos\":" << pos
+                    << ",\"node\":" << graph.get_id(h) << ",\"orientation\":\"" << (graph.get_is_reverse(h) ? '-' : '+') << "\""
+                    << ",\"node_offset\":" << node_offset
+                    << ",\"pangenome_pos\":" << path_index.get_pangenome_pos(path_name, nuc_pos_0) + 1 << "}";
+                if (log_requests) {
+                    std::ostringstream log;
+                    log << "GOT REQUEST : lift " << path_name << ":" << pos << "\n";
+                    std::cout << log.str() << std::flush;
+                }
+                res.set_content(out.str(), "application/json");
+            });
+        }
+
         svr.Get("/stop", [&](const Request& req, Response& res) {
             svr.stop();
         });
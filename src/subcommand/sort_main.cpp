@@ -229,10 +229,8 @@ int main_sort(int argc, char** argv) {
     if (p_sgd || args::get(pipeline).find('Y') != std::string::npos) {
         // take care of path index
         if (xp_in_file) {
-            std::ifstream in;
-            in.open(args::get(xp_in_file));
-            path_index.load(in);
-            in.close();
+            // mapped, so that jobs sharing an index share its pages
+            path_index.load_mmap(args::get(xp_in_file));
         } else {
             path_index.from_handle_graph(graph, num_threads);
         }
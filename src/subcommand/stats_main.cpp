@@ -8,6 +8,7 @@
 #include "algorithms/weakly_connected_components.hpp"
 #include "cover.hpp"
 #include "utils.hpp"
+#include "og_summary.hpp"
 
 //#define debug_odgi_stats
 
@@ -131,6 +132,25 @@ int main_stats(int argc, char** argv) {
 	const uint64_t num_threads = args::get(threads) ? args::get(threads) : 1;
 	omp_set_num_threads(num_threads);
 
+    {
+        // a bare summary of an .og file can be read from its summary section alone
+        const std::string& infile = args::get(dg_in_file);
+        bool summary_only = args::get(_summarize) && !yaml && !args::get(_weakly_connected_components)
+            && !args::get(_num_self_loops) && !args::get(_show_nondeterministic_edges) && !args::get(base_content)
+            && !args::get(mean_links_length) && !args::get(sum_of_path_node_distances);
+        if (summary_only && infile != "-" && !utils::ends_with(infile, "gfa") && !utils::ends_with(infile, "gfa.gz")
+            && !utils::ends_with(infile, "gfa.bgz") && std::filesystem::exists(infile)) {
+            og_summary_reader_t reader(infile);
+            if (reader.has_summary()) {
+                auto& summary = reader.summary();
+                std::cout << "#length\tnodes\tedges\tpaths" << std::endl;
+                std::cout << summary.sequence_length << "\t" << summary.node_count << "\t"
+                          << summary.edge_count << "\t" << summary.path_count << std::endl;
+                return 0;
+            }
+        }
+    }
+
     graph_t graph;
     assert(argc > 0);
     std::string infile = args::get(dg_in_file);
@@ -146,6 +166,8 @@ int main_stats(int argc, char** argv) {
     	std::cout << "---" << std::endl;
     }
 
+    graph.freeze();
+
     if (args::get(_summarize) || yaml) {
         uint64_t length_in_bp = 0, node_count = 0, edge_count = 0, path_count = 0;
         graph.for_each_handle([&](const handle_t& h) {
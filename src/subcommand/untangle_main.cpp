@@ -89,6 +89,8 @@ int main_untangle(int argc, char **argv) {
         }
     }    
 
+    graph.freeze();
+
     // path loading
     auto load_paths = [&](const std::string& path_names_file) {
         std::ifstream path_names_in(path_names_file);
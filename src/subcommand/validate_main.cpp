@@ -66,6 +66,8 @@ namespace odgi {
             }
         }
 
+        graph.freeze();
+
         omp_set_num_threads(num_threads);
 
         bool valid_graph = true;
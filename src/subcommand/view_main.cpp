@@ -2,6 +2,7 @@
 #include "odgi.hpp"
 #include "args.hxx"
 #include "utils.hpp"
+#include "bgzf.hpp"
 
 namespace odgi {
 
@@ -22,6 +23,8 @@ int main_view(int argc, char** argv) {
     args::ValueFlag<std::string> dg_in_file(mandatory_opts, "FILE", "Load the succinct variation graph in ODGI format from this *FILE*. The file name usually ends with *.og*. It also accepts GFAv1, but the on-the-fly conversion to the ODGI format requires additional time!", {'i', "idx"});
     args::Group out_opts(parser, "[ Output Options ]");
     args::Flag to_gfa(out_opts, "to_gfa", "Write the graph in GFAv1 format to standard output.", {'g', "to-gfa"});
+    args::Flag gzip_out(out_opts, "gzip", "Compress the GFAv1 output in BGZF format, which bgzip and gzip can read,"
+                                          " using all threads given with -t, --threads.", {'z', "gzip"});
     args::Flag display(parser, "display", "Show the internal structures of a graph. Print to stdout the maximum"
                                           " node identifier, the minimum node identifier, the nodes vector, the"
                                           " delete nodes bit vector and the path metadata, each in a separate"
@@ -53,6 +56,11 @@ int main_view(int argc, char** argv) {
         return 1;
     }
 
+    if (args::get(gzip_out) && !args::get(to_gfa)) {
+        std::cerr << "[odgi::view] error: please specify -g, --to-gfa with -z, --gzip." << std::endl;
+        return 1;
+    }
+
 	const uint64_t num_threads = args::get(nthreads) ? args::get(nthreads) : 1;
 
     graph_t graph;
@@ -65,11 +73,20 @@ int main_view(int argc, char** argv) {
 			utils::handle_gfa_odgi_input(infile, "view", args::get(progress), num_threads, graph);
         }
     }
+    graph.set_number_of_threads(num_threads);
+    // freezing also lets long paths be written in parallel slices
+    graph.freeze();
     if (args::get(display)) {
         graph.display();
     }
     if (args::get(to_gfa)) {
-        graph.to_gfa(std::cout);
+        if (args::get(gzip_out)) {
+            bgzf::ostream out(std::cout, num_threads);
+            graph.to_gfa(out);
+            out.close();
+        } else {
+            graph.to_gfa(std::cout);
+        }
     }
 
     return 0;
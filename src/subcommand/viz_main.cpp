@@ -235,6 +235,11 @@ namespace odgi {
             }
         }
 
+        graph.freeze();
+        // paths are scanned several times while drawing
+        graph.set_number_of_threads(num_threads);
+        graph.build_path_handle_arrays();
+
         //NOTE: this sample will overwrite the file or test.png without warning!
         //const char* filename = argc > 1 ? argv[1] : "test.png";
         if (args::get(png_out_file).empty()) {
@@ -309,8 +314,8 @@ namespace odgi {
 
                 auto get_path_length = [](const graph_t &graph, const path_handle_t &path_handle) {
                     uint64_t path_len = 0;
-                    graph.for_each_step_in_path(path_handle, [&](const step_handle_t &s) {
-                        path_len += graph.get_length(graph.get_handle_of_step(s));
+                    graph.for_each_handle_in_path(path_handle, [&](const handle_t& h) {
+                        path_len += graph.get_length(h);
                     });
                     return path_len;
                 };
@@ -344,8 +349,7 @@ namespace odgi {
 
                     uint64_t nt_position_in_path = 0;
 
-                    graph.for_each_step_in_path(path_handle, [&](const step_handle_t &occ) {
-                        const handle_t h = graph.get_handle_of_step(occ);
+                    graph.for_each_handle_in_path(path_handle, [&](const handle_t& h) {
                         uint64_t h_pan_pos = position_map[number_bool_packing::unpack_number(h)];
                         uint64_t h_len = graph.get_length(h);
 
@@ -567,8 +571,7 @@ namespace odgi {
                 // get the block which this path covers
                 uint64_t min_x = len_to_visualize;
                 uint64_t max_x = std::numeric_limits<uint64_t>::min(); // 0
-                graph.for_each_step_in_path(path, [&](const step_handle_t &occ) {
-                    handle_t h = graph.get_handle_of_step(occ);
+                graph.for_each_handle_in_path(path, [&](const handle_t& h) {
                     uint64_t p = position_map[number_bool_packing::unpack_number(h)];
 
                     if (p >= pangenomic_start_pos && p <= pangenomic_end_pos) {
@@ -834,8 +837,8 @@ namespace odgi {
                 if (path_rank >= 0 && path_layout_y[path_rank] >= 0){
                     uint64_t curr_len = 0, p, hl;
                     handle_t h;
-                    graph.for_each_step_in_path(path, [&](const step_handle_t &occ) {
-                        h = graph.get_handle_of_step(occ);
+                    graph.for_each_handle_in_path(path, [&](const handle_t& handle) {
+                        h = handle;
                         hl = graph.get_length(h);
 
                         curr_len += hl;
@@ -909,8 +912,8 @@ namespace odgi {
                         handle_t h;
                         uint64_t hl, p;
                         bool is_rev;
-                        graph.for_each_step_in_path(path, [&](const step_handle_t &occ) {
-                            h = graph.get_handle_of_step(occ);
+                        graph.for_each_handle_in_path(path, [&](const handle_t& handle) {
+                            h = handle;
                             is_rev = graph.get_is_reverse(h);
                             hl = graph.get_length(h);
 
@@ -1047,8 +1050,8 @@ namespace odgi {
                     handle_t h;
                     uint64_t p, hl;
 
-                    graph.for_each_step_in_path(path, [&](const step_handle_t &occ) {
-                        h = graph.get_handle_of_step(occ);
+                    graph.for_each_handle_in_path(path, [&](const handle_t& handle) {
+                        h = handle;
                         p = position_map[number_bool_packing::unpack_number(h)];
                         hl = graph.get_length(h);
 
@@ -1107,8 +1110,7 @@ namespace odgi {
 
                 }else{
                     /// Loop over all the steps along a path, from first through last and draw them
-                    graph.for_each_step_in_path(path, [&](const step_handle_t& occ) {
-                        handle_t h = graph.get_handle_of_step(occ);
+                    graph.for_each_handle_in_path(path, [&](const handle_t& h) {
                         uint64_t p = position_map[number_bool_packing::unpack_number(h)];
                         uint64_t hl = graph.get_length(h);
                         // make contects for the bases in the node
@@ -1143,8 +1145,7 @@ namespace odgi {
                     uint64_t max_x = std::numeric_limits<uint64_t>::min(); // 0
 
                     // In binned mode, the min/max_x values changes based on the bin width; in standard mode, _bin_width is 1, so nothing changes here
-                    graph.for_each_step_in_path(path, [&](const step_handle_t &occ) {
-                        handle_t h = graph.get_handle_of_step(occ);
+                    graph.for_each_handle_in_path(path, [&](const handle_t& h) {
                         uint64_t p = position_map[number_bool_packing::unpack_number(h)];
                         min_x = std::min(min_x, (uint64_t)(p / _bin_width));
                         max_x = std::max(max_x, (uint64_t)((p + graph.get_length(h)) / _bin_width));
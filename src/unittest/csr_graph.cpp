@@ -0,0 +1,98 @@
+/**
+ * \file
+ * unittest/csr_graph.cpp: test cases for the CSR adjacency snapshot of a graph.
+ */
+
+#include "catch.hpp"
+
+#include <handlegraph/handle_graph.hpp>
+#include <handlegraph/util.hpp>
+#include "odgi.hpp"
+#include "csr_graph.hpp"
+#include "algorithms/bfs.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+TEST_CASE("CSR snapshots report the same adjacency as their source graph", "[csr]") {
+
+    graph_t graph;
+    handle_t n1 = graph.create_handle("GATT");
+    handle_t n2 = graph.create_handle("A");
+    handle_t n3 = graph.create_handle("CA");
+    handle_t n4 = graph.create_handle("T");
+    handle_t n5 = graph.create_handle("GGG");
+    handle_t n6 = graph.create_handle("C");
+    graph.create_edge(n1, n2);
+    graph.create_edge(n1, graph.flip(n3));
+    graph.create_edge(n2, n4);
+    graph.create_edge(graph.flip(n3), n4);
+    // a non-inverting and an inverting self loop
+    graph.create_edge(n4, n4);
+    graph.create_edge(n5, graph.flip(n5));
+    graph.create_edge(n4, n5);
+    graph.create_edge(graph.flip(n6), n1);
+    // leave a hole in the rank space
+    graph.destroy_handle(n2);
+
+    CSRHandleGraph csr(&graph, 2);
+
+    REQUIRE(csr.get_node_count() == graph.get_node_count());
+    REQUIRE(!csr.has_node(2));
+    REQUIRE(csr.has_node(6));
+    REQUIRE(!csr.has_node(7));
+    REQUIRE(csr.min_node_id() == 1);
+    REQUIRE(csr.max_node_id() == 6);
+
+    auto neighbours = [](const HandleGraph& g, const handle_t& h, bool go_left) {
+        vector<handle_t> found;
+        g.follow_edges(h, go_left, [&](const handle_t& next) {
+            found.push_back(next);
+        });
+        std::sort(found.begin(), found.end(), [](const handle_t& a, const handle_t& b) {
+            return as_integer(a) < as_integer(b);
+        });
+        return found;
+    };
+
+    graph.for_each_handle([&](const handle_t& h) {
+        REQUIRE(csr.get_id(h) == graph.get_id(h));
+        REQUIRE(csr.get_handle(graph.get_id(h)) == h);
+        REQUIRE(csr.get_length(h) == graph.get_length(h));
+        REQUIRE(csr.get_sequence(graph.flip(h)) == graph.get_sequence(graph.flip(h)));
+        for (auto& o : { h, graph.flip(h) }) {
+            for (auto go_left : { false, true }) {
+                auto expected = neighbours(graph, o, go_left);
+                REQUIRE(neighbours(csr, o, go_left) == expected);
+                REQUIRE(csr.get_degree(o, go_left) == expected.size());
+            }
+        }
+    });
+
+    SECTION("Traversals over the snapshot visit the same nodes") {
+        std::vector<nid_t> seen;
+        algorithms::bfs(csr,
+                        [&](const handle_t& h, const uint64_t& r, const uint64_t& l, const uint64_t& d) {
+                            seen.push_back(csr.get_id(h));
+                        },
+                        [&](const handle_t& h) {
+                            return std::find(seen.begin(), seen.end(), csr.get_id(h)) != seen.end();
+                        },
+                        [](const handle_t& l, const handle_t& h) { return false; },
+                        [](void) { return false; },
+                        { graph.flip(n6) },
+                        { },
+                        false);
+        std::sort(seen.begin(), seen.end());
+        REQUIRE(seen == std::vector<nid_t>({ 1, 3, 4, 5, 6 }));
+    }
+}
+
+}
+}
@@ -10,6 +10,7 @@
 #include "odgi.hpp"
 
 #include <iostream>
+#include <sstream>
 #include <limits>
 #include <algorithm>
 #include <vector>
@@ -232,5 +233,60 @@ TEST_CASE( "Follow edges utility works", "[edges]" ) {
     }
 }
 
+TEST_CASE( "Bulk edge creation matches creating edges one by one", "[edges]" ) {
+    std::mt19937 gen(42);
+    const uint64_t n = 2000;
+    graph_t serial;
+    graph_t bulk;
+    for (uint64_t i = 0; i < n; ++i) {
+        serial.create_handle("A");
+        bulk.create_handle("A");
+    }
+    std::uniform_int_distribution<uint64_t> node(1, n);
+    std::uniform_int_distribution<int> coin(0, 1);
+    std::vector<edge_t> edges;
+    for (uint64_t i = 0; i < 20000; ++i) {
+        handle_t a = serial.get_handle(node(gen), coin(gen));
+        handle_t b = coin(gen) && i % 7 == 0 ? serial.flip(a) : serial.get_handle(node(gen), coin(gen));
+        edges.push_back(std::make_pair(a, b));
+        // the same edge seen from the other strand
+        if (i % 5 == 0) {
+            edges.push_back(std::make_pair(serial.flip(b), serial.flip(a)));
+        }
+    }
+    // some edges already exist before the bulk insertion
+    for (uint64_t i = 0; i < 100; ++i) {
+        serial.create_edge(edges[i]);
+        bulk.create_edge(edges[i]);
+    }
+    for (auto& edge : edges) {
+        serial.create_edge(edge);
+    }
+    bulk.set_number_of_threads(3);
+    bulk.create_edges(edges);
+
+    REQUIRE(bulk.get_edge_count() == serial.get_edge_count());
+    uint64_t seen = 0;
+    serial.for_each_edge([&](const edge_t& edge) {
+        REQUIRE(bulk.has_edge(edge.first, edge.second));
+        ++seen;
+    });
+    REQUIRE(seen == serial.get_edge_count());
+    serial.for_each_handle([&](const handle_t& h) {
+        for (auto go_left : { false, true }) {
+            REQUIRE(bulk.get_degree(h, go_left) == serial.get_degree(h, go_left));
+        }
+    });
+    // the records themselves are the same, so both graphs are written the same way
+    std::stringstream serial_gfa, bulk_gfa;
+    serial.to_gfa(serial_gfa);
+    bulk.to_gfa(bulk_gfa);
+    REQUIRE(bulk_gfa.str() == serial_gfa.str());
+    std::stringstream serial_og, bulk_og;
+    serial.serialize(serial_og);
+    bulk.serialize(bulk_og);
+    REQUIRE(bulk_og.str() == serial_og.str());
+}
+
 }
 }
\ No newline at end of file
@@ -7,9 +7,11 @@
 
 #include <iostream>
 #include <random>
+#include <sstream>
 
 #include "src/algorithms/subgraph/extract.hpp"
 #include "src/algorithms/subgraph/region.hpp"
+#include "src/algorithms/xp.hpp"
 
 namespace odgi {
 
@@ -111,5 +113,99 @@ namespace odgi {
 
         }
 
+
+        TEST_CASE("Extracting a path range through the path index", "[extracting]") {
+            graph_t graph;
+            const handle_t n1 = graph.create_handle("ACGT");
+            const handle_t n2 = graph.create_handle("GG");
+            const handle_t n3 = graph.create_handle("TTTAA");
+            const handle_t n4 = graph.create_handle("C");
+            const handle_t n5 = graph.create_handle("GATC");
+            graph.create_edge(n1, n2);
+            graph.create_edge(n2, n3);
+            graph.create_edge(n3, n2);
+            graph.create_edge(n2, n4);
+            graph.create_edge(n4, n5);
+            graph.create_edge(n4, n3);
+            graph.create_edge(n3, n5);
+
+            // x visits node 2 twice, at [4, 6) and [11, 13)
+            auto path_x = graph.create_path_handle("x");
+            graph.append_step(path_x, n1);
+            graph.append_step(path_x, n2);
+            graph.append_step(path_x, n3);
+            graph.append_step(path_x, n2);
+            graph.append_step(path_x, n4);
+            graph.append_step(path_x, n5);
+
+            // y leaves the subgraph between nodes 2 and 3, so it is split in two subpaths
+            auto path_y = graph.create_path_handle("y");
+            graph.append_step(path_y, n1);
+            graph.append_step(path_y, n2);
+            graph.append_step(path_y, n4);
+            graph.append_step(path_y, n3);
+            graph.append_step(path_y, n5);
+
+            xp::XP path_index;
+            path_index.from_handle_graph(graph, 1);
+            path_index.index_node_steps(graph);
+
+            std::vector<path_handle_t> paths;
+            graph.for_each_path_handle([&](const path_handle_t path) {
+                paths.push_back(path);
+            });
+
+            // from the middle of node 2 on its first visit to the middle of node 2 on its second one
+            const uint64_t start = 5;
+            const uint64_t end = 12;
+
+            graph_t expected;
+            algorithms::extract_path_range(graph, path_x, start, end, expected);
+            algorithms::add_connecting_edges_to_subgraph(graph, expected);
+            algorithms::add_subpaths_to_subgraph(graph, paths, expected, 1);
+
+            graph_t subgraph;
+            algorithms::extract_indexed_path_range(graph, path_index, path_index.get_path_handle("x"), start, end, subgraph);
+            algorithms::add_connecting_edges_to_subgraph(graph, subgraph);
+            algorithms::add_indexed_subpaths_to_subgraph(graph, path_index, subgraph);
+
+            auto path_sequence = [&](const std::string& name) {
+                std::string seq;
+                subgraph.for_each_step_in_path(subgraph.get_path_handle(name), [&](const step_handle_t& step) {
+                    seq.append(subgraph.get_sequence(subgraph.get_handle_of_step(step)));
+                });
+                return seq;
+            };
+
+            SECTION("The subgraph is the one odgi extract -r gives") {
+                std::stringstream expected_gfa, observed_gfa;
+                expected.to_gfa(expected_gfa);
+                subgraph.to_gfa(observed_gfa);
+                REQUIRE(observed_gfa.str() == expected_gfa.str());
+            }
+
+            SECTION("Subpaths are named by their range and split where a path leaves the subgraph") {
+                REQUIRE(subgraph.get_node_count() == 2);
+                REQUIRE(subgraph.get_path_count() == 3);
+                REQUIRE(subgraph.has_path("x:4-13"));
+                REQUIRE(path_sequence("x:4-13") == "GGTTTAAGG");
+                REQUIRE(subgraph.has_path("y:4-6"));
+                REQUIRE(path_sequence("y:4-6") == "GG");
+                REQUIRE(subgraph.has_path("y:7-12"));
+                REQUIRE(path_sequence("y:7-12") == "TTTAA");
+            }
+
+            SECTION("The mean depth weighs the partial first and last nodes by the bases they cover") {
+                std::vector<std::pair<nid_t, uint64_t>> step_depths;
+                const double mean_depth = algorithms::indexed_path_range_depth(
+                        graph, path_index, path_index.get_path_handle("x"), start, end, step_depths);
+                // node 2 is visited three times and node 3 twice, over 1 + 5 + 2 of the 8 bases
+                REQUIRE(mean_depth == Approx((3.0 * 1 + 2.0 * 5 + 3.0 * 2) / 8));
+                REQUIRE(step_depths.size() == 3);
+                REQUIRE(step_depths[0] == std::make_pair((nid_t)2, (uint64_t)3));
+                REQUIRE(step_depths[1] == std::make_pair((nid_t)3, (uint64_t)2));
+                REQUIRE(step_depths[2] == std::make_pair((nid_t)2, (uint64_t)3));
+            }
+        }
     }
 }
@@ -0,0 +1,273 @@
+/**
+ * \file
+ * unittest/gfa.cpp: test cases for building graphs from GFA files.
+ */
+
+#include "catch.hpp"
+
+#include <handlegraph/util.hpp>
+#include "odgi.hpp"
+#include "gfa_to_handle.hpp"
+#include "bgzf.hpp"
+#include "algorithms/temp_file.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+TEST_CASE("GFA files are parsed the same way on any number of threads", "[gfa]") {
+
+    // ids start above one and leave a hole, and records are interleaved
+    std::string gfa =
+        "H\tVN:Z:1.0\n"
+        "S\t12\tACGT\n"
+        "S\t11\tGG\tLN:i:2\n"
+        "L\t11\t+\t12\t-\t0M\n"
+        "P\tx\t11+,12-,14+\t*\n"
+        "S\t14\tT\r\n"
+        "L\t12\t-\t14\t+\t0M\n"
+        "L\t12\t-\t14\t+\t0M\n"
+        "P\ty\t14-\t*\n"
+        "P\tempty\t*\t*\n";
+    // a long tail so that the file is split into several chunks
+    const uint64_t tail = 200000;
+    std::stringstream body;
+    body << gfa;
+    for (uint64_t i = 0; i < tail; ++i) {
+        body << "S\t" << 15 + i << "\tCAT\n";
+        body << "L\t" << 14 + i << "\t+\t" << 15 + i << "\t+\t0M\n";
+    }
+    body << "P\tz\t";
+    for (uint64_t i = 0; i <= tail; ++i) {
+        body << 14 + i << "+" << (i < tail ? "," : "");
+    }
+    body << "\t*\n";
+
+    std::string filename = algorithms::temp_file::create("unittest_gfa");
+    std::ofstream out(filename.c_str());
+    out << body.str();
+    out.close();
+
+    graph_t single;
+    gfa_to_handle(filename, &single, 1);
+
+    REQUIRE(single.get_node_count() == 3 + tail);
+    REQUIRE(single.has_node(11));
+    REQUIRE(!single.has_node(13));
+    REQUIRE(single.has_node(14 + tail));
+    REQUIRE(!single.has_node(15 + tail));
+    REQUIRE(single.get_sequence(single.get_handle(14)) == "T");
+    REQUIRE(single.get_sequence(single.get_handle(11)) == "GG");
+    REQUIRE(single.get_edge_count() == 2 + tail);
+    REQUIRE(single.has_edge(single.get_handle(11), single.get_handle(12, true)));
+    REQUIRE(single.get_path_count() == 4);
+    REQUIRE(single.get_step_count(single.get_path_handle("x")) == 3);
+    REQUIRE(single.get_step_count(single.get_path_handle("empty")) == 0);
+    REQUIRE(single.get_step_count(single.get_path_handle("z")) == tail + 1);
+    REQUIRE(single.get_is_reverse(single.get_handle_of_step(single.path_begin(single.get_path_handle("y")))));
+
+    graph_t multi;
+    gfa_to_handle(filename, &multi, 4);
+
+    std::stringstream expected;
+    single.to_gfa(expected);
+    std::stringstream observed;
+    multi.to_gfa(observed);
+    REQUIRE(observed.str() == expected.str());
+
+    algorithms::temp_file::remove(filename);
+}
+
+TEST_CASE("Links survive a round trip through GFA and ODGI", "[gfa]") {
+
+    // links on either strand, two given again from the other strand, and self loops
+    const std::vector<std::vector<std::string>> links = {
+        { "1", "+", "2", "+" },
+        { "2", "+", "3", "-" },
+        { "3", "+", "2", "-" },
+        { "3", "-", "1", "+" },
+        { "1", "+", "1", "-" },
+        { "2", "+", "2", "+" },
+        { "4", "-", "3", "+" },
+        { "2", "-", "1", "-" },
+    };
+    std::stringstream body;
+    body << "H\tVN:Z:1.0\n";
+    const std::vector<std::string> seqs = { "ACGT", "GA", "T", "CCA" };
+    graph_t serial;
+    for (uint64_t i = 0; i < seqs.size(); ++i) {
+        body << "S\t" << i + 1 << "\t" << seqs[i] << "\n";
+        serial.create_handle(seqs[i], i + 1);
+    }
+    for (auto& link : links) {
+        body << "L\t" << link[0] << "\t" << link[1] << "\t" << link[2] << "\t" << link[3] << "\t0M\n";
+        serial.create_edge(serial.get_handle(std::stoll(link[0]), link[1] == "-"),
+                           serial.get_handle(std::stoll(link[2]), link[3] == "-"));
+    }
+    body << "P\tp\t1+,2+,3-\t*\n";
+    path_handle_t p = serial.create_path_handle("p");
+    serial.append_step(p, serial.get_handle(1));
+    serial.append_step(p, serial.get_handle(2));
+    serial.append_step(p, serial.get_handle(3, true));
+    std::stringstream expected;
+    serial.to_gfa(expected);
+
+    std::string filename = algorithms::temp_file::create("unittest_gfa");
+    {
+        std::ofstream out(filename.c_str());
+        out << body.str();
+    }
+    graph_t imported;
+    gfa_to_handle(filename, &imported, 2);
+    REQUIRE(imported.get_edge_count() == 6);
+    std::stringstream observed;
+    imported.to_gfa(observed);
+    REQUIRE(observed.str() == expected.str());
+    // one L line per edge
+    uint64_t link_lines = 0;
+    std::string line;
+    while (std::getline(observed, line)) {
+        link_lines += line[0] == 'L';
+    }
+    REQUIRE(link_lines == 6);
+
+    // through the ODGI format and back to GFA
+    std::stringstream og;
+    imported.serialize(og);
+    graph_t loaded;
+    loaded.deserialize(og);
+    std::stringstream reloaded;
+    loaded.to_gfa(reloaded);
+    REQUIRE(reloaded.str() == expected.str());
+
+    // and the GFA we wrote reads back to itself
+    {
+        std::ofstream out(filename.c_str());
+        out << reloaded.str();
+    }
+    graph_t reimported;
+    gfa_to_handle(filename, &reimported, 2);
+    std::stringstream rewritten;
+    reimported.to_gfa(rewritten);
+    REQUIRE(rewritten.str() == expected.str());
+
+    algorithms::temp_file::remove(filename);
+}
+
+TEST_CASE("Compressed GFA files load like uncompressed ones", "[gfa]") {
+
+    std::stringstream body;
+    body << "H\tVN:Z:1.0\n";
+    // enough records to fill several BGZF blocks
+    const uint64_t n = 50000;
+    for (uint64_t i = 1; i <= n; ++i) {
+        body << "S\t" << i << "\t" << (i % 2 ? "ACGT" : "GA") << "\n";
+        if (i > 1) body << "L\t" << i - 1 << "\t+\t" << i << "\t" << (i % 3 ? "+" : "-") << "\t0M\n";
+    }
+    body << "P\tp\t1+,2+,3-\t*\n";
+    // a path line longer than a batch of inflated data, so that it spans several batches
+    body << "P\tlong\t";
+    const uint64_t long_steps = 3000000;
+    for (uint64_t i = 0; i < long_steps; ++i) {
+        body << i % n + 1 << (i % 7 ? "+" : "-") << (i + 1 < long_steps ? "," : "");
+    }
+    body << "\t*\n";
+    body << "S\t" << n + 1 << "\tTTT\n";
+
+    std::string plain_name = algorithms::temp_file::create("unittest_gfa");
+    {
+        std::ofstream out(plain_name.c_str());
+        out << body.str();
+    }
+    graph_t plain;
+    gfa_to_handle(plain_name, &plain, 2);
+    REQUIRE(plain.get_step_count(plain.get_path_handle("long")) == long_steps);
+    REQUIRE(plain.has_node(n + 1));
+    std::stringstream expected;
+    plain.to_gfa(expected);
+
+    SECTION("BGZF written by our own stream is read on several threads") {
+        std::string bgzf_name = algorithms::temp_file::create("unittest_gfa");
+        {
+            std::ofstream file(bgzf_name.c_str());
+            bgzf::ostream out(file, 3);
+            out << body.str();
+            out.close();
+        }
+        graph_t graph;
+        gfa_to_handle(bgzf_name, &graph, 4);
+        std::stringstream observed;
+        graph.to_gfa(observed);
+        REQUIRE(observed.str() == expected.str());
+        algorithms::temp_file::remove(bgzf_name);
+    }
+
+    SECTION("Plain gzip made of several members is read") {
+        std::string gz_name = algorithms::temp_file::create("unittest_gfa");
+        std::string data = body.str();
+        uint64_t half = data.size() / 2;
+        for (auto& part : { data.substr(0, half), data.substr(half) }) {
+            gzFile gz = gzopen(gz_name.c_str(), "ab");
+            REQUIRE(gz != nullptr);
+            gzwrite(gz, part.data(), part.size());
+            gzclose(gz);
+        }
+        graph_t graph;
+        gfa_to_handle(gz_name, &graph, 4);
+        std::stringstream observed;
+        graph.to_gfa(observed);
+        REQUIRE(observed.str() == expected.str());
+        algorithms::temp_file::remove(gz_name);
+    }
+
+    algorithms::temp_file::remove(plain_name);
+}
+
+TEST_CASE("GFA output does not depend on the number of threads", "[gfa]") {
+
+    graph_t graph;
+    const uint64_t n = 40000;
+    std::vector<handle_t> handles;
+    for (uint64_t i = 0; i < n; ++i) {
+        handles.push_back(graph.create_handle(i % 2 ? "ACG" : "T"));
+        if (i) graph.create_edge(handles[i - 1], i % 3 ? handles[i] : graph.flip(handles[i]));
+    }
+    graph.destroy_handle(handles[5]);
+    path_handle_t short_path = graph.create_path_handle("short", true);
+    graph.append_step(short_path, handles[0]);
+    graph.append_step(short_path, graph.flip(handles[1]));
+    graph.create_path_handle("empty");
+    // long enough to be written in several slices
+    path_handle_t long_path = graph.create_path_handle("long");
+    for (uint64_t i = 0; i < (1 << 20) + 1000; ++i) {
+        graph.append_step(long_path, handles[6 + i % 1000]);
+    }
+
+    graph.set_number_of_threads(1);
+    std::stringstream expected;
+    graph.to_gfa(expected);
+    REQUIRE(expected.str().find("P\tshort\t1+,2-\t*\tTP:Z:circular\n") != std::string::npos);
+    REQUIRE(expected.str().find("P\tempty\t\t*\n") != std::string::npos);
+
+    graph.set_number_of_threads(4);
+    std::stringstream unfrozen;
+    graph.to_gfa(unfrozen);
+    REQUIRE(unfrozen.str() == expected.str());
+
+    graph.freeze();
+    std::stringstream frozen;
+    graph.to_gfa(frozen);
+    REQUIRE(frozen.str() == expected.str());
+}
+
+}
+}
@@ -2301,5 +2301,213 @@ TEST_CASE("Deletable handle graphs with mutable paths work", "[handle][packed][h
     
 }
 
+TEST_CASE("Frozen graphs answer queries but refuse modification", "[handle]") {
+
+    graph_t graph;
+    handle_t h1 = graph.create_handle("CAT");
+    handle_t h2 = graph.create_handle("GA");
+    handle_t h3 = graph.create_handle("T");
+    graph.create_edge(h1, h2);
+    graph.create_edge(h2, h3);
+    path_handle_t p = graph.create_path_handle("p");
+    graph.append_step(p, h1);
+    graph.append_step(p, graph.flip(h2));
+    graph.append_step(p, h3);
+
+    graph.freeze();
+    REQUIRE(graph.is_frozen());
+
+    vector<handle_t> walked;
+    graph.for_each_step_in_path(p, [&](const step_handle_t& step) {
+        walked.push_back(graph.get_handle_of_step(step));
+        REQUIRE(graph.get_path_handle_of_step(step) == p);
+    });
+    REQUIRE(walked == vector<handle_t>{h1, graph.flip(h2), h3});
+    REQUIRE(graph.get_sequence(graph.flip(h2)) == "TC");
+    REQUIRE(graph.get_length(h1) == 3);
+    REQUIRE(graph.get_step_count(h2) == 1);
+    REQUIRE(graph.has_edge(h1, h2));
+
+    REQUIRE_THROWS(graph.create_handle("A"));
+    REQUIRE_THROWS(graph.create_edge(h1, h3));
+    REQUIRE_THROWS(graph.append_step(p, h1));
+    REQUIRE_THROWS(graph.destroy_handle(h3));
+    REQUIRE(!graph.has_edge(h1, h3));
+    REQUIRE(graph.get_step_count(p) == 3);
+
+    graph.thaw();
+    graph.create_edge(h1, h3);
+    REQUIRE(graph.has_edge(h1, h3));
+}
+
+TEST_CASE("Path handle arrays match a walk over the steps", "[handle]") {
+    graph_t graph;
+    handle_t h1 = graph.create_handle("GAT");
+    handle_t h2 = graph.create_handle("GA");
+    handle_t h3 = graph.create_handle("C");
+    graph.create_edge(h1, h2);
+    graph.create_edge(h2, graph.flip(h3));
+    graph.create_edge(graph.flip(h3), h1);
+    path_handle_t p1 = graph.create_path_handle("p1");
+    for (uint64_t i = 0; i < 1000; ++i) {
+        graph.append_step(p1, h1);
+        graph.append_step(p1, h2);
+        graph.append_step(p1, graph.flip(h3));
+    }
+    path_handle_t p2 = graph.create_path_handle("p2");
+    graph.append_step(p2, h2);
+    path_handle_t p3 = graph.create_path_handle("empty");
+
+    auto walk = [&](const path_handle_t& p) {
+        vector<handle_t> walked;
+        graph.for_each_step_in_path(p, [&](const step_handle_t& step) {
+            walked.push_back(graph.get_handle_of_step(step));
+        });
+        return walked;
+    };
+    auto scan = [&](const path_handle_t& p) {
+        vector<handle_t> scanned;
+        graph.for_each_handle_in_path(p, [&](const handle_t& h) {
+            scanned.push_back(h);
+        });
+        return scanned;
+    };
+
+    REQUIRE(scan(p1) == walk(p1));
+    REQUIRE_THROWS(graph.get_path_handles(p1));
+
+    graph.freeze();
+    // scanning a frozen path walks its steps until its array is built
+    REQUIRE(scan(p1) == walk(p1));
+    REQUIRE(graph.get_path_handles(p1) == walk(p1));
+    REQUIRE(graph.get_path_handles(p1).size() == 3000);
+    REQUIRE(scan(p1) == walk(p1));
+    REQUIRE(scan(p2) == vector<handle_t>{h2});
+    graph.set_number_of_threads(2);
+    graph.build_path_handle_arrays();
+    REQUIRE(graph.get_path_handles(p3).empty());
+
+    // arrays are dropped on thaw, so edits made afterwards are seen when refrozen
+    graph.thaw();
+    graph.append_step(p2, h3);
+    graph.freeze();
+    REQUIRE(graph.get_path_handles(p2) == vector<handle_t>{h2, h3});
+}
+
+TEST_CASE("Node records are laid out in the order applied to the graph", "[handle]") {
+
+    graph_t graph;
+    vector<handle_t> handles;
+    for (uint64_t i = 0; i < 10000; ++i) {
+        handles.push_back(graph.create_handle(i % 2 ? "ACGT" : "GATTACAGATTACA"));
+        if (i) graph.create_edge(handles[i-1], handles[i]);
+    }
+    // the slot of a destroyed node is reused
+    graph.destroy_handle(handles[17]);
+    handle_t recycled = graph.create_handle("T", 20000);
+    path_handle_t p = graph.create_path_handle("p");
+    for (uint64_t i = 0; i < handles.size(); ++i) {
+        if (i != 17) graph.append_step(p, handles[i]);
+    }
+    REQUIRE(graph.get_sequence(recycled) == "T");
+
+    // reverse the order and flip every other node
+    vector<handle_t> order;
+    graph.for_each_handle([&](const handle_t& h) {
+        order.push_back(graph.get_id(h) % 2 ? graph.flip(h) : h);
+    });
+    std::reverse(order.begin(), order.end());
+    std::vector<std::string> sequences;
+    for (auto& h : order) {
+        sequences.push_back(graph.get_sequence(h));
+    }
+    graph.set_number_of_threads(3);
+    graph.apply_ordering(order, true);
+
+    REQUIRE(graph.get_node_count() == order.size());
+    uint64_t i = 0;
+    graph.for_each_handle([&](const handle_t& h) {
+        REQUIRE(graph.get_id(h) == i + 1);
+        REQUIRE(graph.get_sequence(h) == sequences[i]);
+        ++i;
+    });
+    for (uint64_t j = 1; j < graph.node_v.size(); ++j) {
+        REQUIRE(graph.node_v[j] - graph.node_v[j-1] == 1);
+    }
+    REQUIRE(graph.get_step_count(graph.get_path_handle("p")) == 9999);
+}
+
+TEST_CASE("Path metadata is kept in a table indexed by path handle", "[handle]") {
+
+    graph_t graph;
+    handle_t h1 = graph.create_handle("A");
+    handle_t h2 = graph.create_handle("CC");
+    graph.create_edge(h1, h2);
+    // enough paths to spread over several blocks of the table
+    const uint64_t n = 5000;
+    for (uint64_t i = 0; i < n; ++i) {
+        path_handle_t p = graph.create_path_handle("p" + std::to_string(i), i % 7 == 0);
+        graph.append_step(p, i % 2 ? h1 : h2);
+        if (i % 3 == 0) graph.append_step(p, h2);
+    }
+    REQUIRE(graph.get_path_count() == n);
+    for (uint64_t i = 0; i < n; i += 97) {
+        path_handle_t p = graph.get_path_handle("p" + std::to_string(i));
+        REQUIRE(as_integer(p) == i + 1);
+        REQUIRE(graph.get_path_name(p) == "p" + std::to_string(i));
+        REQUIRE(graph.get_step_count(p) == (i % 3 == 0 ? 2 : 1));
+        REQUIRE(graph.get_is_circular(p) == (i % 7 == 0));
+    }
+
+    graph.destroy_path(graph.get_path_handle("p10"));
+    REQUIRE(!graph.has_path("p10"));
+    REQUIRE(graph.get_path_count() == n - 1);
+    uint64_t seen = 0;
+    graph.for_each_path_handle([&](const path_handle_t& p) {
+        REQUIRE(graph.get_path_name(p) != "p10");
+        ++seen;
+    });
+    REQUIRE(seen == n - 1);
+
+    // a new path takes a fresh handle
+    path_handle_t extra = graph.create_path_handle("extra");
+    REQUIRE(as_integer(extra) == n + 1);
+    REQUIRE(graph.get_step_count(extra) == 0);
+    REQUIRE(graph.get_path_handle("extra") == extra);
+
+    graph.clear_paths();
+    REQUIRE(graph.get_path_count() == 0);
+    REQUIRE(!graph.has_path("p0"));
+    path_handle_t again = graph.create_path_handle("p0");
+    REQUIRE(as_integer(again) == 1);
+    REQUIRE(graph.get_path_name(again) == "p0");
+}
+
+TEST_CASE("Path metadata follows a new path order", "[handle]") {
+
+    graph_t graph;
+    handle_t h1 = graph.create_handle("A");
+    handle_t h2 = graph.create_handle("CC");
+    graph.create_edge(h1, h2);
+    path_handle_t a = graph.create_path_handle("a");
+    graph.append_step(a, h1);
+    path_handle_t b = graph.create_path_handle("b", true);
+    graph.append_step(b, h1);
+    graph.append_step(b, h2);
+    path_handle_t c = graph.create_path_handle("c");
+    graph.append_step(c, h2);
+
+    graph.apply_path_ordering({c, a, b});
+    REQUIRE(graph.get_path_name(as_path_handle(1)) == "c");
+    REQUIRE(graph.get_path_name(as_path_handle(2)) == "a");
+    REQUIRE(graph.get_path_name(as_path_handle(3)) == "b");
+    path_handle_t new_b = graph.get_path_handle("b");
+    REQUIRE(as_integer(new_b) == 3);
+    REQUIRE(graph.get_step_count(new_b) == 2);
+    REQUIRE(graph.get_is_circular(new_b));
+    REQUIRE(graph.get_path(graph.path_begin(new_b)) == new_b);
+    REQUIRE(graph.get_handle_of_step(graph.path_back(new_b)) == h2);
+}
+
 }
 }
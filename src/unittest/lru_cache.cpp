@@ -0,0 +1,75 @@
+/**
+ * \file
+ * unittest/lru_cache.cpp: test cases for the byte-bounded LRU cache.
+ */
+
+#include "catch.hpp"
+
+#include "lru_cache.hpp"
+
+#include <memory>
+#include <string>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+
+TEST_CASE("The LRU cache evicts the least recently used entries", "[lru_cache]") {
+
+    // three entries of a one-byte key and a four-byte value fit
+    lru_cache_t cache(15);
+    auto value = [](const std::string& v) { return std::make_shared<const std::string>(v); };
+
+    cache.put("a", value("AAAA"));
+    cache.put("b", value("BBBB"));
+    cache.put("c", value("CCCC"));
+    REQUIRE(cache.size() == 3);
+    REQUIRE(cache.bytes() == 15);
+
+    SECTION("Lookups count hits and misses") {
+        REQUIRE(*cache.get("a") == "AAAA");
+        REQUIRE(cache.get("d") == nullptr);
+        REQUIRE(cache.hits() == 1);
+        REQUIRE(cache.misses() == 1);
+    }
+
+    SECTION("A new entry evicts the least recently used one") {
+        // "a" was used last, so "b" is the oldest
+        REQUIRE(cache.get("a") != nullptr);
+        cache.put("d", value("DDDD"));
+        REQUIRE(cache.size() == 3);
+        REQUIRE(cache.evictions() == 1);
+        REQUIRE(cache.get("b") == nullptr);
+        REQUIRE(*cache.get("a") == "AAAA");
+        REQUIRE(*cache.get("c") == "CCCC");
+        REQUIRE(*cache.get("d") == "DDDD");
+    }
+
+    SECTION("A replaced entry is charged for its new value") {
+        cache.put("b", value("BB"));
+        REQUIRE(cache.size() == 3);
+        REQUIRE(cache.bytes() == 13);
+        REQUIRE(*cache.get("b") == "BB");
+        cache.put("b", value("BBBBBBBB"));
+        // "a" is evicted to make room
+        REQUIRE(cache.bytes() == 14);
+        REQUIRE(cache.get("a") == nullptr);
+        REQUIRE(*cache.get("b") == "BBBBBBBB");
+    }
+
+    SECTION("Values larger than the cache are not kept") {
+        auto held = cache.get("a");
+        cache.put("e", value(std::string(20, 'E')));
+        REQUIRE(cache.get("e") == nullptr);
+        REQUIRE(cache.size() == 3);
+        cache.clear();
+        REQUIRE(cache.size() == 0);
+        REQUIRE(cache.bytes() == 0);
+        // a value that was handed out outlives its entry
+        REQUIRE(*held == "AAAA");
+    }
+}
+
+}
+}
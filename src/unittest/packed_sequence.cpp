@@ -0,0 +1,94 @@
+/**
+ * \file
+ * unittest/packed_sequence.cpp: test cases for 2-bit packed node sequences.
+ */
+
+#include "catch.hpp"
+
+#include <handlegraph/util.hpp>
+#include "odgi.hpp"
+#include "packed_sequence.hpp"
+#include "dna.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+TEST_CASE("Packed sequences read back exactly", "[packed_sequence]") {
+
+    std::vector<std::string> seqs = {
+        "",
+        "A",
+        "GATTACA",
+        "ACGTACGTACGTACGTACGTACGTACGTACGT", // fits in place
+        "ACGTACGTACGTACGTACGTACGTACGTACGTA",
+        std::string(1000, 'C') + std::string(500, 'N') + "ACGTRYKM" + std::string(999, 'G') + "n",
+        "acgtNNNN",                          // no smaller when packed
+        "MKVLAAGIRSTWHEPQ",                  // not DNA at all
+    };
+    for (auto& seq : seqs) {
+        packed_sequence_t packed;
+        packed.assign(seq);
+        REQUIRE(packed.size() == seq.size());
+        REQUIRE(packed.str() == seq);
+        for (uint64_t i = 0; i < seq.size(); i += 7) {
+            REQUIRE(packed.at(i) == seq[i]);
+        }
+        // every alignment of a range against the packed bytes
+        for (uint64_t offset = 0; offset < std::min(seq.size(), (size_t)9); ++offset) {
+            uint64_t count = std::min(seq.size() - offset, (size_t)1003);
+            std::string range;
+            packed.extract(offset, count, range);
+            REQUIRE(range == seq.substr(offset, count));
+            std::string rc_range;
+            packed.extract_reverse_complement(offset, count, rc_range);
+            REQUIRE(rc_range == reverse_complement(seq.substr(offset, count)));
+        }
+
+        packed_sequence_t copied(packed);
+        REQUIRE(copied.str() == seq);
+        packed_sequence_t moved(std::move(copied));
+        REQUIRE(moved.str() == seq);
+        moved.reverse_complement_in_place();
+        REQUIRE(moved.str() == reverse_complement(seq));
+
+        std::stringstream buffer;
+        uint64_t written = packed.serialize(buffer);
+        REQUIRE(written == buffer.str().size());
+        packed_sequence_t loaded;
+        loaded.load(buffer);
+        REQUIRE(loaded.str() == seq);
+    }
+
+    packed_sequence_t dna;
+    dna.assign(std::string(4000, 'A') + std::string(10, 'N'));
+    REQUIRE(dna.is_packed());
+    packed_sequence_t protein;
+    protein.assign("MKVLAAGIRSTWHEPQ");
+    REQUIRE(!protein.is_packed());
+}
+
+TEST_CASE("Graph sequence accessors decode only what they return", "[packed_sequence]") {
+
+    graph_t graph;
+    handle_t h = graph.create_handle("ACGTTNNNGCA");
+    handle_t r = graph.flip(h);
+    REQUIRE(graph.get_sequence(h) == "ACGTTNNNGCA");
+    REQUIRE(graph.get_sequence(r) == "TGCNNNAACGT");
+    REQUIRE(graph.get_base(h, 4) == 'T');
+    REQUIRE(graph.get_base(r, 0) == 'T');
+    REQUIRE(graph.get_base(r, 10) == 'T');
+    REQUIRE(graph.get_subsequence(h, 3, 4) == "TTNN");
+    REQUIRE(graph.get_subsequence(r, 1, 4) == "GCNN");
+    REQUIRE(graph.get_subsequence(r, 8, 100) == "CGT");
+    REQUIRE(graph.get_subsequence(h, 20, 5) == "");
+}
+
+}
+}
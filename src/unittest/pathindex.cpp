@@ -9,6 +9,9 @@
 #include "odgi.hpp"
 #include "algorithms/xp.hpp"
 #include <sdsl/bit_vectors.hpp>
+#include <sstream>
+#include <cstring>
+#include <fstream>
 
 namespace odgi {
     namespace unittest {
@@ -305,6 +308,324 @@ namespace odgi {
                 // REQUIRE(loaded_path_index.get_pangenome_pos("5", 24) == 0);
                 // REQUIRE(loaded_path_index.get_pangenome_pos("4", 1) == 0);
             }
+
+            SECTION("A mapped index answers like the loaded one") {
+                XP mapped_path_index;
+                mapped_path_index.load_mmap(basename + "unittest_pathindex.xp");
+                REQUIRE(mapped_path_index.path_count == loaded_path_index.path_count);
+                for (auto& name : { "5", "5-", "5-m" }) {
+                    REQUIRE(mapped_path_index.has_path(name));
+                    path_handle_t p = mapped_path_index.get_path_handle(name);
+                    REQUIRE(p == loaded_path_index.get_path_handle(name));
+                    REQUIRE(mapped_path_index.get_path_name(p) == name);
+                    REQUIRE(mapped_path_index.get_path_step_count(p) == loaded_path_index.get_path_step_count(p));
+                    REQUIRE(mapped_path_index.get_path_length(p) == loaded_path_index.get_path_length(p));
+                    for (size_t pos = 0; pos < loaded_path_index.get_path_length(p); ++pos) {
+                        step_handle_t step = mapped_path_index.get_step_at_position(p, pos);
+                        REQUIRE(step == loaded_path_index.get_step_at_position(p, pos));
+                        REQUIRE(mapped_path_index.get_handle_of_step(step) == loaded_path_index.get_handle_of_step(step));
+                        REQUIRE(mapped_path_index.get_position_of_step(step) == loaded_path_index.get_position_of_step(step));
+                        REQUIRE(mapped_path_index.get_pangenome_pos(name, pos) == loaded_path_index.get_pangenome_pos(name, pos));
+                    }
+                    REQUIRE(!mapped_path_index.has_position(name, loaded_path_index.get_path_length(p)));
+                }
+                // the views read the node->path vectors in place, before they are copied out
+                mapped_int_vector np_view = mapped_path_index.get_np_bv_view();
+                mapped_int_vector nr_view = mapped_path_index.get_nr_iv_view();
+                mapped_int_vector npi_view = mapped_path_index.get_npi_iv_view();
+                REQUIRE(np_view.size() == loaded_path_index.get_np_bv().size());
+                REQUIRE(nr_view.size() == loaded_path_index.get_nr_iv().size());
+                REQUIRE(npi_view.size() == loaded_path_index.get_npi_iv().size());
+                for (size_t i = 0; i < np_view.size(); ++i) {
+                    REQUIRE(np_view[i] == loaded_path_index.get_np_bv()[i]);
+                    REQUIRE(nr_view[i] == loaded_path_index.get_nr_iv()[i]);
+                    REQUIRE(npi_view[i] == loaded_path_index.get_npi_iv()[i]);
+                }
+                const sdsl::bit_vector& np_bv = mapped_path_index.get_np_bv();
+                REQUIRE(np_bv == loaded_path_index.get_np_bv());
+                // once copied out, the views read the copies
+                REQUIRE(mapped_path_index.get_npi_iv_view().size() == npi_view.size());
+                REQUIRE(mapped_path_index.get_npi_iv_view()[0] == npi_view[0]);
+                REQUIRE(mapped_path_index.get_nr_iv() == loaded_path_index.get_nr_iv());
+                REQUIRE(mapped_path_index.get_npi_iv() == loaded_path_index.get_npi_iv());
+
+                // and writes the same index back out
+                std::stringstream written, rewritten;
+                loaded_path_index.serialize_members(written);
+                mapped_path_index.serialize_members(rewritten);
+                REQUIRE(written.str() == rewritten.str());
+            }
+
+            SECTION("An index written before the record table existed is mapped by loading it") {
+                // the old layout is the new one without the record table and its trailer
+                std::stringstream written;
+                loaded_path_index.serialize_members(written);
+                std::string old_layout = written.str();
+                REQUIRE(old_layout.size() > (loaded_path_index.path_count + 3) * sizeof(uint64_t));
+                old_layout.resize(old_layout.size() - (loaded_path_index.path_count + 3) * sizeof(uint64_t));
+                uint64_t marker = 0;
+                std::memcpy(&marker, old_layout.data() + old_layout.size() - sizeof(uint64_t), sizeof(marker));
+                REQUIRE(marker != XP_RECORD_TABLE_MARKER);
+                std::ofstream old_out(basename + "unittest_pathindex_old.xp", std::ios::binary);
+                old_out.write(old_layout.data(), old_layout.size());
+                old_out.close();
+
+                XP old_path_index;
+                old_path_index.load_mmap(basename + "unittest_pathindex_old.xp");
+                REQUIRE(old_path_index.path_count == loaded_path_index.path_count);
+                for (auto& name : { "5", "5-", "5-m" }) {
+                    REQUIRE(old_path_index.has_path(name));
+                    path_handle_t p = old_path_index.get_path_handle(name);
+                    REQUIRE(old_path_index.get_path_length(p) == loaded_path_index.get_path_length(p));
+                    for (size_t pos = 0; pos < loaded_path_index.get_path_length(p); ++pos) {
+                        REQUIRE(old_path_index.get_pangenome_pos(name, pos) == loaded_path_index.get_pangenome_pos(name, pos));
+                    }
+                }
+                REQUIRE(old_path_index.get_np_bv() == loaded_path_index.get_np_bv());
+                REQUIRE(old_path_index.get_nr_iv() == loaded_path_index.get_nr_iv());
+                REQUIRE(old_path_index.get_npi_iv() == loaded_path_index.get_npi_iv());
+                std::stringstream rewritten;
+                old_path_index.serialize_members(rewritten);
+                REQUIRE(rewritten.str() == written.str());
+            }
+
+            SECTION("The index does not depend on the number of threads") {
+                XP threaded_path_index;
+                threaded_path_index.from_handle_graph(graph, 4);
+                std::stringstream single, threaded;
+                path_index.serialize_members(single);
+                threaded_path_index.serialize_members(threaded);
+                REQUIRE(single.str() == threaded.str());
+            }
+
+            SECTION("Path names are found the same way with a name hash") {
+                XP hashed_path_index;
+                hashed_path_index.load_mmap(basename + "unittest_pathindex.xp");
+                REQUIRE(!hashed_path_index.has_path_name_index());
+                hashed_path_index.index_path_names(2);
+                REQUIRE(hashed_path_index.has_path_name_index());
+                for (auto& name : { "5", "5-", "5-m" }) {
+                    REQUIRE(hashed_path_index.has_path(name));
+                    REQUIRE(hashed_path_index.get_path_handle(name) == loaded_path_index.get_path_handle(name));
+                    REQUIRE(hashed_path_index.get_pangenome_pos(name, 1) == loaded_path_index.get_pangenome_pos(name, 1));
+                }
+                for (auto& name : { "", "4", "5-m-", "-m", "5m" }) {
+                    REQUIRE(!hashed_path_index.has_path(name));
+                    REQUIRE(as_integer(hashed_path_index.get_path_handle(name)) == 0);
+                }
+                hashed_path_index.clean();
+                REQUIRE(!hashed_path_index.has_path_name_index());
+            }
+
+            SECTION("Batched pangenome positions match single lookups") {
+                std::vector<std::pair<std::string, size_t>> queries;
+                for (auto& name : { "5-m", "5", "5-" }) {
+                    size_t length = loaded_path_index.get_path_length(loaded_path_index.get_path_handle(name));
+                    for (size_t pos = length; pos > 0; --pos) {
+                        queries.push_back(std::make_pair(name, pos - 1));
+                    }
+                    queries.push_back(std::make_pair(name, length));
+                }
+                queries.push_back(std::make_pair("4", 0));
+                std::vector<size_t> results;
+                loaded_path_index.get_pangenome_positions(queries, results, 2);
+                REQUIRE(results.size() == queries.size());
+                for (size_t i = 0; i < queries.size(); ++i) {
+                    if (loaded_path_index.has_position(queries[i].first, queries[i].second)) {
+                        REQUIRE(results[i] == loaded_path_index.get_pangenome_pos(queries[i].first, queries[i].second));
+                    } else {
+                        REQUIRE(results[i] == XP_NO_PANGENOME_POS);
+                    }
+                }
+            }
+
+            SECTION("Sorting node-path records in memory or on disk gives the same index") {
+                XP in_memory_path_index, on_disk_path_index;
+                in_memory_path_index.from_handle_graph(graph, 2, node_path_sort_t::in_memory);
+                on_disk_path_index.from_handle_graph(graph, 2, node_path_sort_t::on_disk);
+                REQUIRE(in_memory_path_index.get_np_bv() == on_disk_path_index.get_np_bv());
+                REQUIRE(in_memory_path_index.get_nr_iv() == on_disk_path_index.get_nr_iv());
+                REQUIRE(in_memory_path_index.get_npi_iv() == on_disk_path_index.get_npi_iv());
+                std::stringstream in_memory, on_disk;
+                in_memory_path_index.serialize_members(in_memory);
+                on_disk_path_index.serialize_members(on_disk);
+                REQUIRE(in_memory.str() == on_disk.str());
+            }
+        }
+
+        TEST_CASE("Adding paths to and removing paths from an XP index", "[pathindex]") {
+
+            graph_t graph;
+            handle_t n1 = graph.create_handle("AGGA");
+            handle_t n2 = graph.create_handle("A");
+            handle_t n3 = graph.create_handle("TC");
+            handle_t n4 = graph.create_handle("TCTCAGG");
+            graph.create_edge(n1, n2);
+            graph.create_edge(n2, n3);
+            graph.create_edge(n3, n4);
+            graph.create_edge(n1, n4);
+            graph.create_edge(n4, graph.flip(n3));
+
+            path_handle_t a = graph.create_path_handle("a");
+            graph.append_step(a, n1);
+            graph.append_step(a, n2);
+            graph.append_step(a, n3);
+            graph.append_step(a, n4);
+            path_handle_t b = graph.create_path_handle("b");
+            graph.append_step(b, n1);
+            graph.append_step(b, n4);
+
+            XP path_index;
+            path_index.from_handle_graph(graph, 2);
+            path_index.index_path_names();
+
+            auto same_as_rebuilt = [&](const XP& updated) {
+                XP rebuilt;
+                rebuilt.from_handle_graph(graph, 2);
+                std::stringstream updated_out, rebuilt_out;
+                updated.serialize_members(updated_out);
+                rebuilt.serialize_members(rebuilt_out);
+                REQUIRE(updated_out.str() == rebuilt_out.str());
+            };
+
+            path_handle_t c = graph.create_path_handle("c");
+            graph.append_step(c, n1);
+            graph.append_step(c, n2);
+            graph.append_step(c, n3);
+            graph.append_step(c, graph.flip(n3));
+            path_index.add_paths(graph, { c }, 2);
+
+            SECTION("Added paths are indexed as if the index had been rebuilt") {
+                REQUIRE(path_index.path_count == 3);
+                REQUIRE(path_index.has_path_name_index());
+                REQUIRE(path_index.has_path("c"));
+                REQUIRE(path_index.get_path_length(path_index.get_path_handle("c")) == 9);
+                REQUIRE(path_index.get_pangenome_pos("c", 7) == 6);
+                same_as_rebuilt(path_index);
+            }
+
+            SECTION("Removed paths are dropped as if the index had been rebuilt") {
+                path_index.remove_paths(graph, { a });
+                graph.destroy_path(a);
+                REQUIRE(path_index.path_count == 2);
+                REQUIRE(!path_index.has_path("a"));
+                REQUIRE(path_index.get_path_handle("b") == as_path_handle(1));
+                REQUIRE(path_index.get_path_handle("c") == as_path_handle(2));
+                same_as_rebuilt(path_index);
+            }
+
+            SECTION("The steps on each node are found through the node step index") {
+                // each step of the index is on the node the graph puts it on
+                auto check_steps = [&](const XP& index) {
+                    REQUIRE(index.has_node_step_index());
+                    graph.for_each_handle([&](const handle_t& h) {
+                        std::vector<std::string> graph_steps, index_steps;
+                        graph.for_each_step_on_handle(h, [&](const step_handle_t& step) {
+                            graph_steps.push_back(graph.get_path_name(graph.get_path_handle_of_step(step)));
+                        });
+                        index.for_each_step_on_handle(h, [&](const step_handle_t& step) {
+                            REQUIRE(graph.get_id(index.get_handle_of_step(step)) == graph.get_id(h));
+                            index_steps.push_back(index.get_path_name(index.get_path_handle_of_step(step)));
+                            return true;
+                        });
+                        std::sort(graph_steps.begin(), graph_steps.end());
+                        std::sort(index_steps.begin(), index_steps.end());
+                        REQUIRE(graph_steps == index_steps);
+                    });
+                };
+                REQUIRE(!path_index.has_node_step_index());
+                path_index.index_node_steps(graph, 2);
+                check_steps(path_index);
+                // "c" steps on n3 twice, in both orientations
+                std::vector<size_t> positions;
+                path_index.for_each_step_on_handle(n3, [&](const step_handle_t& step) {
+                    if (path_index.get_path_handle_of_step(step) == path_index.get_path_handle("c")) {
+                        positions.push_back(path_index.get_position_of_step(step));
+                    }
+                    return true;
+                });
+                std::sort(positions.begin(), positions.end());
+                REQUIRE(positions == std::vector<size_t>({ 5, 7 }));
+                // and updates keep the node step index
+                path_index.remove_paths(graph, { b });
+                graph.destroy_path(b);
+                check_steps(path_index);
+                path_index.clean();
+                REQUIRE(!path_index.has_node_step_index());
+            }
+        }
+
+        TEST_CASE("XP construction on a graph with gaps in its node ids", "[pathindex]") {
+
+            graph_t graph;
+            handle_t n1 = graph.create_handle("AGGA");
+            handle_t n2 = graph.create_handle("CCC");
+            handle_t n3 = graph.create_handle("TC");
+            handle_t n4 = graph.create_handle("TCTCAGG");
+            graph.create_edge(n1, n3);
+            graph.create_edge(n3, n4);
+            graph.create_edge(n1, graph.flip(n4));
+            graph.destroy_handle(n2);
+            n1 = graph.get_handle(1);
+            n3 = graph.get_handle(3);
+            n4 = graph.get_handle(4);
+
+            path_handle_t p = graph.create_path_handle("p");
+            graph.append_step(p, n1);
+            graph.append_step(p, n3);
+            graph.append_step(p, n4);
+            path_handle_t q = graph.create_path_handle("q");
+            graph.append_step(q, n1);
+            graph.append_step(q, graph.flip(n4));
+
+            REQUIRE(graph.get_node_count() == 3);
+            REQUIRE(!graph.has_node(2));
+
+            XP path_index;
+            path_index.from_handle_graph(graph, 2);
+
+            // nodes 1, 3 and 4 start at 0, 4 and 6 in the pangenome
+            auto check = [&](const XP& index) {
+                for (size_t pos = 0; pos < 13; ++pos) {
+                    REQUIRE(index.get_pangenome_pos("p", pos) == pos);
+                }
+                for (size_t pos = 0; pos < 4; ++pos) {
+                    REQUIRE(index.get_pangenome_pos("q", pos) == pos);
+                }
+                for (size_t pos = 4; pos < 11; ++pos) {
+                    REQUIRE(index.get_pangenome_pos("q", pos) == 12 - (pos - 4));
+                }
+                REQUIRE(index.get_handle_of_step(index.get_step_at_position(index.get_path_handle("p"), 5)) == n3);
+                REQUIRE(index.get_np_bv().size() == 5);
+            };
+
+            SECTION("The index resolves positions on the remaining nodes") {
+                check(path_index);
+            }
+
+            SECTION("The index keeps its node ranks when written and read back") {
+                std::string basename = temp_file::create();
+                std::ofstream out(basename + "unittest_pathindex_gaps.xp");
+                path_index.serialize_members(out);
+                out.close();
+                XP loaded_path_index;
+                std::ifstream in(basename + "unittest_pathindex_gaps.xp");
+                loaded_path_index.load(in);
+                in.close();
+                check(loaded_path_index);
+                XP mapped_path_index;
+                mapped_path_index.load_mmap(basename + "unittest_pathindex_gaps.xp");
+                check(mapped_path_index);
+            }
+
+            SECTION("Sorting node-path records in memory or on disk agrees on the node ranks") {
+                XP in_memory_path_index, on_disk_path_index;
+                in_memory_path_index.from_handle_graph(graph, 2, node_path_sort_t::in_memory);
+                on_disk_path_index.from_handle_graph(graph, 2, node_path_sort_t::on_disk);
+                REQUIRE(in_memory_path_index.get_np_bv() == on_disk_path_index.get_np_bv());
+                REQUIRE(in_memory_path_index.get_nr_iv() == on_disk_path_index.get_nr_iv());
+                REQUIRE(in_memory_path_index.get_npi_iv() == on_disk_path_index.get_npi_iv());
+            }
         }
     }
 }
@@ -0,0 +1,357 @@
+/**
+ * \file
+ * unittest/serialize.cpp: test cases for writing and reading graphs in ODGI format.
+ */
+
+#include "catch.hpp"
+
+#include <handlegraph/util.hpp>
+#include "odgi.hpp"
+#include "og_summary.hpp"
+#include "algorithms/temp_file.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace odgi {
+
+int main_stats(int argc, char** argv);
+
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+TEST_CASE("Graphs survive a round trip through the ODGI format", "[serialize]") {
+
+    graph_t graph;
+    handle_t n1 = graph.create_handle("AGGA");
+    handle_t n2 = graph.create_handle("A");
+    handle_t n3 = graph.create_handle("TC");
+    handle_t n4 = graph.create_handle("TCTCAGG");
+    handle_t n5 = graph.create_handle("G");
+    graph.create_edge(n1, n2);
+    graph.create_edge(n2, n3);
+    graph.create_edge(n2, n4);
+    graph.create_edge(n3, n4);
+    graph.create_edge(n4, graph.flip(n3));
+    graph.create_edge(n4, n5);
+
+    path_handle_t p1 = graph.create_path_handle("p1");
+    graph.append_step(p1, n1);
+    graph.append_step(p1, n2);
+    graph.append_step(p1, n4);
+    path_handle_t p2 = graph.create_path_handle("p2");
+    graph.append_step(p2, n1);
+    graph.append_step(p2, n2);
+    graph.append_step(p2, n3);
+    graph.append_step(p2, n4);
+    graph.append_step(p2, graph.flip(n3));
+
+    // leave a hole in the id space, which is stored as an empty node record
+    graph.destroy_handle(n5);
+
+    std::stringstream expected;
+    graph.to_gfa(expected);
+
+    SECTION("Loading from a stream") {
+        std::stringstream buffer;
+        graph.serialize(buffer);
+        graph_t loaded;
+        loaded.deserialize(buffer);
+        std::stringstream observed;
+        loaded.to_gfa(observed);
+        REQUIRE(observed.str() == expected.str());
+        REQUIRE(loaded.get_node_count() == 4);
+        REQUIRE(!loaded.has_node(5));
+        REQUIRE(loaded.get_edge_count() == graph.get_edge_count());
+        // the slot of the deleted record is handed to the next node created
+        handle_t added = loaded.create_handle("GATTACA");
+        REQUIRE(loaded.get_sequence(added) == "GATTACA");
+        REQUIRE(loaded.get_node_count() == 5);
+        loaded.destroy_handle(added);
+        std::stringstream reloaded;
+        loaded.to_gfa(reloaded);
+        REQUIRE(reloaded.str() == expected.str());
+    }
+
+    SECTION("Loading from a memory-mapped file") {
+        std::string filename = algorithms::temp_file::create("unittest_serialize");
+        std::ofstream out(filename.c_str());
+        graph.serialize(out);
+        out.close();
+        graph_t loaded;
+        loaded.deserialize_mmap(filename);
+        std::stringstream observed;
+        loaded.to_gfa(observed);
+        REQUIRE(observed.str() == expected.str());
+        REQUIRE(loaded.get_path_count() == 2);
+        REQUIRE(loaded.get_step_count(loaded.get_path_handle("p2")) == 5);
+        algorithms::temp_file::remove(filename);
+    }
+}
+
+TEST_CASE("A footer with a section count larger than the file is not trusted", "[serialize]") {
+
+    graph_t graph;
+    handle_t n1 = graph.create_handle("GATT");
+    handle_t n2 = graph.create_handle("ACA");
+    graph.create_edge(n1, n2);
+    path_handle_t p = graph.create_path_handle("p");
+    graph.append_step(p, n1);
+    graph.append_step(p, n2);
+    std::stringstream expected;
+    graph.to_gfa(expected);
+
+    std::stringstream buffer;
+    graph.serialize(buffer);
+    std::string bytes = buffer.str();
+    // the section count is the second to last word of the footer
+    const uint64_t section_count = (uint64_t)1 << 40;
+    bytes.replace(bytes.size() - 2*sizeof(uint64_t), sizeof(uint64_t), (const char*)&section_count, sizeof(uint64_t));
+    std::string filename = algorithms::temp_file::create("unittest_serialize");
+    {
+        std::ofstream out(filename.c_str());
+        out << bytes;
+    }
+    // the file is read as a stream, which does not need the section offsets
+    graph_t loaded;
+    loaded.deserialize_mmap(filename);
+    std::stringstream observed;
+    loaded.to_gfa(observed);
+    REQUIRE(observed.str() == expected.str());
+    algorithms::temp_file::remove(filename);
+}
+
+TEST_CASE("Graphs spanning many node chunks are encoded and decoded in parallel", "[serialize]") {
+
+    graph_t graph;
+    graph.set_number_of_threads(4);
+    const uint64_t n = 3 * OG_NODE_CHUNK_SIZE + 17;
+    handle_t prev = graph.create_handle("A");
+    path_handle_t path = graph.create_path_handle("chain");
+    graph.append_step(path, prev);
+    for (uint64_t i = 1; i < n; ++i) {
+        handle_t curr = graph.create_handle(i % 2 ? "C" : "GT");
+        graph.create_edge(prev, curr);
+        graph.append_step(path, curr);
+        prev = curr;
+    }
+    for (uint64_t i = 0; i < 100; ++i) {
+        path_handle_t p = graph.create_path_handle("short" + std::to_string(i));
+        graph.append_step(p, graph.get_handle(i + 1));
+    }
+
+    std::stringstream expected;
+    graph.to_gfa(expected);
+
+    std::string filename = algorithms::temp_file::create("unittest_serialize");
+    std::ofstream out(filename.c_str());
+    graph.serialize(out);
+    out.close();
+
+    SECTION("Loading from a stream") {
+        std::ifstream in(filename.c_str());
+        graph_t loaded;
+        loaded.set_number_of_threads(3);
+        loaded.deserialize(in);
+        std::stringstream observed;
+        loaded.to_gfa(observed);
+        REQUIRE(observed.str() == expected.str());
+    }
+
+    SECTION("Loading from a memory-mapped file") {
+        graph_t loaded;
+        loaded.set_number_of_threads(5);
+        loaded.deserialize_mmap(filename);
+        std::stringstream observed;
+        loaded.to_gfa(observed);
+        REQUIRE(observed.str() == expected.str());
+        REQUIRE(loaded.get_path_handle("short42") == graph.get_path_handle("short42"));
+    }
+
+    algorithms::temp_file::remove(filename);
+}
+
+TEST_CASE("Summaries and path names are read without loading the graph", "[serialize]") {
+
+    graph_t graph;
+    handle_t n1 = graph.create_handle("AGGA");
+    handle_t n2 = graph.create_handle("NNA");
+    handle_t n3 = graph.create_handle("TC");
+    handle_t n4 = graph.create_handle("G");
+    graph.create_edge(n1, n2);
+    graph.create_edge(n2, n3);
+    graph.create_edge(n1, n3);
+    graph.create_edge(n3, n4);
+    path_handle_t p1 = graph.create_path_handle("first");
+    graph.append_step(p1, n1);
+    graph.append_step(p1, n2);
+    graph.append_step(p1, n3);
+    path_handle_t p2 = graph.create_path_handle("second");
+    graph.append_step(p2, n1);
+    graph.append_step(p2, n3);
+    graph.destroy_handle(n4);
+
+    std::string filename = algorithms::temp_file::create("unittest_serialize");
+    std::ofstream out(filename.c_str());
+    graph.serialize(out);
+    out.close();
+
+    og_summary_reader_t reader(filename);
+    REQUIRE(reader.version() == OG_FORMAT_VERSION);
+    REQUIRE(reader.has_summary());
+    auto& summary = reader.summary();
+    REQUIRE(summary.node_count == graph.get_node_count());
+    REQUIRE(summary.edge_count == graph.get_edge_count());
+    REQUIRE(summary.path_count == graph.get_path_count());
+    REQUIRE(summary.step_count == 5);
+    REQUIRE(summary.sequence_length == 9);
+    REQUIRE(summary.min_node_id == graph.min_node_id());
+    REQUIRE(summary.max_node_id == graph.max_node_id());
+
+    REQUIRE(reader.has_path_metadata());
+    std::vector<std::string> names;
+    std::vector<uint64_t> step_counts;
+    reader.for_each_path([&](const path_handle_t& p, const std::string& name, uint64_t step_count) {
+            REQUIRE(p == graph.get_path_handle(name));
+            names.push_back(name);
+            step_counts.push_back(step_count);
+        });
+    REQUIRE(names == std::vector<std::string>({ "first", "second" }));
+    REQUIRE(step_counts == std::vector<uint64_t>({ 3, 2 }));
+
+    SECTION("The summary does not disturb reading graphs back to back from a stream") {
+        std::stringstream both;
+        graph.serialize(both);
+        graph.serialize(both);
+        graph_t first;
+        first.deserialize(both);
+        graph_t second;
+        second.deserialize(both);
+        REQUIRE(second.get_node_count() == graph.get_node_count());
+        REQUIRE(second.get_path_count() == graph.get_path_count());
+        REQUIRE(second.get_step_count(second.get_path_handle("first")) == 3);
+    }
+
+    algorithms::temp_file::remove(filename);
+}
+
+TEST_CASE("The summary agrees with the graph odgi stats -S loads", "[serialize]") {
+
+    graph_t graph;
+    handle_t n1 = graph.create_handle("CAT");
+    handle_t n2 = graph.create_handle("GA");
+    handle_t n3 = graph.create_handle("TTAG");
+    handle_t n4 = graph.create_handle("C");
+    graph.create_edge(n1, n2);
+    // the same edge from its other strand
+    graph.create_edge(graph.flip(n2), graph.flip(n1));
+    graph.create_edge(n2, n3);
+    graph.create_edge(n2, graph.flip(n3));
+    graph.create_edge(n3, n3);
+    graph.create_edge(n1, graph.flip(n1));
+    graph.create_edge(n3, n4);
+    graph.create_edge(n4, n4);
+    // a node with a self loop takes its edges with it
+    graph.destroy_handle(n4);
+    path_handle_t p = graph.create_path_handle("p");
+    graph.append_step(p, n1);
+    graph.append_step(p, n2);
+    graph.append_step(p, n3);
+
+    std::string filename = algorithms::temp_file::create("unittest_serialize");
+    std::ofstream out(filename.c_str());
+    graph.serialize(out);
+    out.close();
+
+    // the output of odgi stats -i input -S
+    auto summarize = [&](const std::string& input) {
+        std::vector<std::string> args = { "odgi", "stats", "-i", input, "-S" };
+        std::vector<char*> argv;
+        for (auto& arg : args) {
+            argv.push_back(&arg[0]);
+        }
+        std::stringstream captured;
+        auto* cout_buf = std::cout.rdbuf(captured.rdbuf());
+        REQUIRE(main_stats(argv.size(), argv.data()) == 0);
+        std::cout.rdbuf(cout_buf);
+        return captured.str();
+    };
+
+    // read from the summary section
+    const std::string from_summary = summarize(filename);
+    // a stream cannot be mapped, so the graph is loaded and its edges counted
+    std::ifstream in(filename.c_str());
+    auto* cin_buf = std::cin.rdbuf(in.rdbuf());
+    const std::string from_graph = summarize("-");
+    std::cin.rdbuf(cin_buf);
+
+    REQUIRE(from_summary == from_graph);
+    REQUIRE(from_summary == "#length\tnodes\tedges\tpaths\n9\t3\t5\t1\n");
+
+    algorithms::temp_file::remove(filename);
+}
+
+TEST_CASE("Path steps can be left in the file until they are needed", "[serialize]") {
+
+    graph_t graph;
+    handle_t prev = graph.create_handle("A");
+    path_handle_t p = graph.create_path_handle("p");
+    graph.append_step(p, prev);
+    for (uint64_t i = 1; i < 3*OG_NODE_CHUNK_SIZE; ++i) {
+        handle_t curr = graph.create_handle(i % 3 ? "GAT" : "TACA");
+        graph.create_edge(prev, curr);
+        graph.append_step(p, curr);
+        prev = curr;
+    }
+    // a node without steps that we can remove before the steps are loaded
+    handle_t lone = graph.create_handle("CC");
+
+    std::stringstream expected;
+    graph.to_gfa(expected);
+
+    std::string filename = algorithms::temp_file::create("unittest_serialize");
+    std::ofstream out(filename.c_str());
+    graph.serialize(out);
+    out.close();
+
+    graph_t loaded;
+    loaded.set_number_of_threads(3);
+    loaded.set_deferred_path_steps(true);
+    loaded.deserialize_mmap(filename);
+    REQUIRE(loaded.get_node_count() == graph.get_node_count());
+    REQUIRE(loaded.get_edge_count() == graph.get_edge_count());
+    REQUIRE(loaded.get_path_count() == 1);
+
+    SECTION("Reading a step decodes them") {
+        REQUIRE(loaded.get_step_count(loaded.get_handle(2)) == 1);
+        std::stringstream observed;
+        loaded.to_gfa(observed);
+        REQUIRE(observed.str() == expected.str());
+    }
+
+    SECTION("Nodes removed beforehand stay removed") {
+        loaded.destroy_handle(loaded.get_handle(graph.get_id(lone)));
+        REQUIRE(!loaded.has_node(graph.get_id(lone)));
+        uint64_t steps = 0;
+        loaded.for_each_step_in_path(loaded.get_path_handle("p"), [&](const step_handle_t& step) {
+                ++steps;
+            });
+        REQUIRE(steps == 3*OG_NODE_CHUNK_SIZE);
+    }
+
+    SECTION("Clearing the paths drops them unread") {
+        loaded.clear_paths();
+        REQUIRE(loaded.get_path_count() == 0);
+        REQUIRE(loaded.get_step_count(loaded.get_handle(2)) == 0);
+    }
+
+    algorithms::temp_file::remove(filename);
+}
+
+}
+}
@@ -61,12 +61,13 @@ namespace utils {
 	}
 
 	int handle_gfa_odgi_input(const std::string infile, const std::string subcommmand_name, const bool progress,
-							const uint64_t num_threads, odgi::graph_t &graph) {
+							const uint64_t num_threads, odgi::graph_t &graph, const bool defer_path_steps) {
 		if (!std::filesystem::exists(infile)) {
 			std::cerr << "[odgi::" << subcommmand_name << "] error: the given file \"" << infile << "\" does not exist. Please specify an existing input file in ODGI format via -i=[FILE], --idx=[FILE]." << std::endl;
 			return 1;
 		}
-		if (utils::ends_with(infile, "gfa")) {
+		if (utils::ends_with(infile, "gfa") || utils::ends_with(infile, "gfa.gz")
+			|| utils::ends_with(infile, "gfa.bgz")) {
 			if (progress) {
 				std::cerr << "[odgi::" << subcommmand_name << "] warning: the given file \"" << infile << "\" is not in ODGI format. "
 																				   "To save time in the future, please use odgi build -i=[FILE], --idx=[FILE] -o=[FILE], --out=[FILE] "
@@ -75,9 +76,10 @@ namespace utils {
 			gfa_to_handle(infile, &graph, num_threads, progress);
 			graph.set_number_of_threads(num_threads);
 		} else {
-			ifstream f(infile.c_str());
-			graph.deserialize(f);
-			f.close();
+			// map the file so that node records are decoded straight out of the page cache
+			graph.set_number_of_threads(num_threads);
+			graph.set_deferred_path_steps(defer_path_steps);
+			graph.deserialize_mmap(infile);
 		}
 		return 0;
     }
@@ -13,8 +13,10 @@ namespace utils {
     void graph_deep_copy(const odgi::graph_t &source,
                          odgi::graph_t* target);
 	bool ends_with(const std::string &fullString, const std::string &ending);
+	/// Load a graph in GFA or ODGI format. With defer_path_steps, path steps in an
+	/// ODGI file are only decoded if something touches them.
 	int handle_gfa_odgi_input(const std::string infile, const std::string subcommmand_name, const bool progress,
-							  const uint64_t num_threads, odgi::graph_t &graph);
+							  const uint64_t num_threads, odgi::graph_t &graph, const bool defer_path_steps = false);
 }
 
 